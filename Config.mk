@@ -13,6 +13,13 @@ LIBDIR_TEST = $(ROOT)/tests/libtap
 
 LIBSRC_TEST = $(LIBDIR_TEST)/tap.c
 LIBOBJ_TEST = $(BINDIR_TEST)/tap.o
+LIBRARIES_TEST = -lm
+
+HOSTDIR = $(ROOT)/host
+TOOLDIR_HOST = $(ROOT)/host/tools
+BINDIR_HOST = $(ROOT)/bin/host
+OUTNAME_HOST = robot
+LIBRARIES_HOST = -lm
 
 SUBDIRS = $(SRCDIR)
 
@@ -75,6 +82,9 @@ LDFLAGS  := -Wall $(MCUCFLAGS) $(MCULFLAGS) -Wl,--gc-sections
 CFLAGS_TEST := -c -Wall -std=gnu99 -Werror=implicit-function-declaration
 LDFLAGS_TEST := -Wall -Wl,--gc-sections
 
+CFLAGS_HOST := -c -Wall -std=gnu99 -Werror=implicit-function-declaration -fsigned-char -O2 -g -pthread
+LDFLAGS_HOST := -Wall -pthread
+
 
 #
 # Tools
@@ -86,3 +96,4 @@ CC := $(MCUPREFIX)gcc
 CPPCC := $(MCUPREFIX)g++
 OBJCOPY := $(MCUPREFIX)objcopy
 CC_TEST := gcc
+CC_HOST := gcc
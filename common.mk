@@ -10,14 +10,17 @@ else
 endif
 
 INCLUDE := -I$(INCDIR) -I$(SRCDIR)
-BINDIRS := $(BINDIR) $(BINDIR_TEST)
+BINDIRS := $(BINDIR) $(BINDIR_TEST) $(BINDIR_HOST)
 
 INCLUDE_TEST = $(INCLUDE) -I$(LIBDIR_TEST)
+# The host's API.h must be found before the Cortex's.
+INCLUDE_HOST = -I$(HOSTDIR) $(INCLUDE)
 
 HEADERS := \
 	$(wildcard $(SRCDIR)/*.$(HEXT)) \
 	$(wildcard $(INCDIR)/*.$(HEXT)) \
-	$(wildcard $(LIBDIR_TEST)/*.$(HEXT))
+	$(wildcard $(LIBDIR_TEST)/*.$(HEXT)) \
+	$(wildcard $(HOSTDIR)/*.$(HEXT))
 
 ASMSRC := $(wildcard $(SRCDIR)/*.$(ASMEXT))
 CPPSRC := $(wildcard $(SRCDIR)/*.$(CPPEXT))
@@ -31,3 +34,14 @@ COBJ_TEST := $(patsubst $(SRCDIR)/%.$(CEXT), $(BINDIR_TEST)/%.$(OEXT), $(CSRC))
 TESTOBJ   := $(patsubst $(SRCDIR_TEST)/%.$(CEXT_TEST), $(BINDIR_TEST)/%.$(OEXT_TEST), $(CSRC_TEST))
 OUT := $(BINDIR)/$(OUTNAME)
 OUT_TEST := $(patsubst %.$(OEXT_TEST), %$(EXESUFFIX), $(TESTOBJ))
+
+CSRC_HOST := $(wildcard $(HOSTDIR)/*.$(CEXT))
+COBJ_HOST := $(patsubst $(SRCDIR)/%.$(CEXT), $(BINDIR_HOST)/%.$(OEXT), $(CSRC))
+HOSTOBJ   := $(patsubst $(HOSTDIR)/%.$(CEXT), $(BINDIR_HOST)/host-%.$(OEXT), $(CSRC_HOST))
+OUT_HOST := $(BINDIR_HOST)/$(OUTNAME_HOST)$(EXESUFFIX)
+
+# Host tools each have their own main, so link without the robot's.
+CSRC_HOSTTOOL := $(wildcard $(TOOLDIR_HOST)/*.$(CEXT))
+HOSTTOOLOBJ := $(patsubst $(TOOLDIR_HOST)/%.$(CEXT), $(BINDIR_HOST)/tool-%.$(OEXT), $(CSRC_HOSTTOOL))
+HOSTLIBOBJ := $(COBJ_HOST) $(filter-out $(BINDIR_HOST)/host-main.$(OEXT), $(HOSTOBJ))
+OUT_HOSTTOOL := $(patsubst $(TOOLDIR_HOST)/%.$(CEXT), $(BINDIR_HOST)/%$(EXESUFFIX), $(CSRC_HOSTTOOL))
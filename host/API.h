@@ -0,0 +1,163 @@
+/** @file API.h
+ * @brief Host stand-in for the PROS API, for building the firmware on a workstation.
+ *
+ * Only the subset of include/API.h that src/ uses is declared here, with the same
+ * signatures and constants. The host build puts this directory ahead of include/ on the
+ * include path, so <API.h> resolves here and the firmware sources compile unchanged.
+ *
+ * Standard I/O is the real C library's: stdin and stdout are the process's, in place of the
+ * PC debug terminal. Tasks run in virtual time (see host/kernel.c), and the robot's ports are
+ * simulated (see host/io.c and host.h).
+ */
+
+#ifndef API_H_
+#define API_H_
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+// Begin C++ extern to C
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// -------------------- VEX competition functions --------------------
+
+#define JOY_DOWN 1
+#define JOY_LEFT 2
+#define JOY_UP 4
+#define JOY_RIGHT 8
+
+bool isAutonomous();
+bool isEnabled();
+bool isJoystickConnected(unsigned char joystick);
+bool isOnline();
+int joystickGetAnalog(unsigned char joystick, unsigned char axis);
+bool joystickGetDigital(unsigned char joystick, unsigned char buttonGroup,
+	unsigned char button);
+unsigned int powerLevelBackup();
+unsigned int powerLevelMain();
+
+// -------------------- Basic I/O --------------------
+
+#define BOARD_NR_ADC_PINS 8
+#define BOARD_NR_GPIO_PINS 27
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x0A
+#define INPUT_ANALOG 0x00
+#define INPUT_FLOATING 0x04
+#define OUTPUT 0x01
+#define OUTPUT_OD 0x05
+
+int analogCalibrate(unsigned char channel);
+int analogRead(unsigned char channel);
+int analogReadCalibrated(unsigned char channel);
+int analogReadCalibratedHR(unsigned char channel);
+bool digitalRead(unsigned char pin);
+void digitalWrite(unsigned char pin, bool value);
+void pinMode(unsigned char pin, unsigned char mode);
+
+int motorGet(unsigned char channel);
+void motorSet(unsigned char channel, int speed);
+void motorStop(unsigned char channel);
+void motorStopAll();
+
+// -------------------- Integrated Motor Encoders --------------------
+
+#define IME_ADDR_MAX 0x1F
+
+unsigned int imeInitializeAll();
+bool imeGet(unsigned char address, int *value);
+bool imeGetVelocity(unsigned char address, int *value);
+bool imeReset(unsigned char address);
+void imeShutdown();
+
+// -------------------- Sensors --------------------
+
+typedef void * Gyro;
+int gyroGet(Gyro gyro);
+Gyro gyroInit(unsigned char port, unsigned short multiplier);
+void gyroReset(Gyro gyro);
+void gyroShutdown(Gyro gyro);
+
+typedef void * Encoder;
+int encoderGet(Encoder enc);
+Encoder encoderInit(unsigned char portTop, unsigned char portBottom, bool reverse);
+void encoderReset(Encoder enc);
+void encoderShutdown(Encoder enc);
+
+typedef void * Ultrasonic;
+int ultrasonicGet(Ultrasonic ult);
+Ultrasonic ultrasonicInit(unsigned char portEcho, unsigned char portPing);
+void ultrasonicShutdown(Ultrasonic ult);
+
+// -------------------- Character input and output --------------------
+
+// The Cortex's UARTs are not simulated; writes to them are dropped.
+#define uart1 ((FILE *)NULL)
+#define uart2 ((FILE *)NULL)
+
+void lcdInit(FILE *lcdPort);
+
+// Lines starting "@<milliseconds> " are held back until then, so that a
+// script can be fed to stdin. Blocks forever at end of input, as the debug
+// terminal would, rather than handing the pigeon task an endless run of
+// EOFs.
+char* hostFgets(char *str, int num, FILE *stream);
+#define fgets hostFgets
+
+// -------------------- Real time scheduler control --------------------
+
+#define TASK_MAX 16
+#define TASK_MAX_PRIORITIES 6
+#define TASK_PRIORITY_LOWEST 0
+#define TASK_PRIORITY_DEFAULT 2
+#define TASK_PRIORITY_HIGHEST (TASK_MAX_PRIORITIES - 1)
+#define TASK_DEFAULT_STACK_SIZE 512
+#define TASK_MINIMAL_STACK_SIZE	64
+#define TASK_DEAD 0
+#define TASK_RUNNING 1
+#define TASK_RUNNABLE 2
+#define TASK_SLEEPING 3
+#define TASK_SUSPENDED 4
+
+typedef void * TaskHandle;
+typedef void * Mutex;
+typedef void * Semaphore;
+typedef void (*TaskCode)(void *);
+
+TaskHandle taskCreate(TaskCode taskCode, const unsigned int stackDepth, void *parameters,
+	const unsigned int priority);
+void taskDelay(const unsigned long msToDelay);
+void taskDelayUntil(unsigned long *previousWakeTime, const unsigned long cycleTime);
+unsigned int taskGetCount();
+unsigned int taskPriorityGet(TaskHandle task);
+void taskPrioritySet(TaskHandle task, const unsigned int newPriority);
+
+Semaphore semaphoreCreate();
+bool semaphoreGive(Semaphore semaphore);
+bool semaphoreTake(Semaphore semaphore, const unsigned long blockTime);
+void semaphoreDelete(Semaphore semaphore);
+
+Mutex mutexCreate();
+bool mutexGive(Mutex mutex);
+bool mutexTake(Mutex mutex, const unsigned long blockTime);
+void mutexDelete(Mutex mutex);
+
+void delay(const unsigned long time);
+void delayMicroseconds(const unsigned long us);
+unsigned long micros();
+unsigned long millis();
+void wait(const unsigned long time);
+void waitUntil(unsigned long *previousWakeTime, const unsigned long time);
+
+// End C++ wrapper
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,465 @@
+#include "batch.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "plant.h"
+#include "episode.h"
+#include "shims.h"
+
+
+#define WIDTH BATCH_WIDTH
+#define NUMOFGAINS BATCH_NUMOFGAINS
+#define FRAME EPISODE_FRAME
+// As plant.c
+#define STEP 0.0005f
+#define UNUSED(x) (void)(x)
+
+// Lane by lane, mask ? a : b, and |x|; macros, as vectors this wide are
+// passed differently with and without AVX.
+#define SELECT(mask, a, b) ((Floats)(((mask) & (Ints)(a)) | (~(mask) & (Ints)(b))))
+#define ABSOLUTE(x) ((Floats)((Ints)(x) & 0x7fffffff))
+
+// The vector kernels, built again for AVX2 where the toolchain can pick
+// between builds at load time. AVX2 does not bring FMA with it, so both
+// builds round alike.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define KERNEL
+#endif
+
+
+// Typedefs {{{
+
+// GCC vector extensions: arithmetic is lane by lane, comparisons give -1
+// or 0 in each lane.
+typedef float Floats __attribute__((vector_size(WIDTH * sizeof(float))));
+typedef int Ints __attribute__((vector_size(WIDTH * sizeof(int))));
+typedef double Doubles __attribute__((vector_size(WIDTH * sizeof(double))));
+
+// WIDTH lanes, a field at a time.
+typedef struct
+BatchBlock
+{
+    // Plant constants, as plant.c derives them
+    Floats motorCount;
+    Floats ratio;
+    Floats torqueConstant;
+    Floats speedConstant;
+    Floats resistance;
+    Floats sag;
+    Floats inertia;
+    Floats frictionCoulomb;
+    Floats frictionViscous;
+    Floats frictionDrag;
+    Floats shotLoss;
+    Floats shotDuration;
+
+    // Plant state
+    Floats battery;
+    Floats command;
+    Floats speed;
+    Floats shotTorque;
+    Floats shotRemaining;
+    Doubles angle;
+
+    // Controller: the raw reading in, then the low pass filter's state,
+    // which is also the filtered measurement
+    Floats gains[NUMOFGAINS];
+    Floats reading;
+    Floats measured;
+    Floats derivative;
+    Floats integral;
+    Floats action;
+}
+BatchBlock;
+
+// What only changes once a frame stays scalar, lane by lane.
+typedef struct
+BatchLane
+{
+    PlantSetup setup;
+    long readTicks;
+    unsigned int random;
+}
+BatchLane;
+
+struct Batch
+{
+    BatchLaw law;
+    unsigned int count;
+    unsigned int blockCount;
+    BatchBlock * blocks;
+    BatchLane * lanes;
+    double time;
+    double readTime;
+};
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void reset(Batch*);
+static void frame(Batch*, float target);
+static void sense(Batch*);
+static void shoot(Batch*);
+static void control(BatchBlock*, BatchLaw, float target);
+static void step(BatchBlock*, float dt);
+static BatchBlock * blockOf(Batch*, unsigned int lane);
+static float gaussian(BatchLane*);
+static unsigned int nextRandom(BatchLane*);
+
+// }}}
+
+
+
+// Public methods {{{
+
+Batch *
+batchInit(BatchLaw law, unsigned int count)
+{
+    Batch * batch = malloc(sizeof(Batch));
+    batch->law = law;
+    batch->count = count;
+    batch->blockCount = (count + WIDTH - 1) / WIDTH;
+
+    void * blocks = NULL;
+    posix_memalign(&blocks, __alignof__(BatchBlock), batch->blockCount * sizeof(BatchBlock));
+    batch->blocks = blocks;
+    batch->lanes = malloc(batch->blockCount * WIDTH * sizeof(BatchLane));
+
+    const float gains[NUMOFGAINS] = {0};
+    for (unsigned int i = 0; i < batch->blockCount * WIDTH; i++)
+    {
+        batchSetLane(batch, i, plantSetupDefault(), gains);
+    }
+    return batch;
+}
+
+void
+batchDelete(Batch * batch)
+{
+    free(batch->blocks);
+    free(batch->lanes);
+    free(batch);
+}
+
+void
+batchSetLane(Batch * batch, unsigned int lane, PlantSetup setup, const float gains[NUMOFGAINS])
+{
+    BatchBlock * block = blockOf(batch, lane);
+    unsigned int i = lane % WIDTH;
+
+    PlantMotor motor = plantMotorModel(setup.motorType);
+    float count = setup.motorCount;
+
+    block->motorCount[i] = count;
+    block->ratio[i] = setup.ratio;
+    block->torqueConstant[i] = motor.torqueConstant;
+    block->speedConstant[i] = motor.speedConstant;
+    block->resistance[i] = motor.resistance;
+    block->sag[i] = setup.batteryResistance * count / motor.resistance;
+    block->inertia[i] = setup.inertia;
+    block->frictionCoulomb[i] = setup.frictionCoulomb;
+    block->frictionViscous[i] = setup.frictionViscous;
+    block->frictionDrag[i] = setup.frictionDrag;
+    block->shotLoss[i] = setup.shotLoss;
+    block->shotDuration[i] = setup.shotDuration;
+    for (int j = 0; j < NUMOFGAINS; j++) block->gains[j][i] = gains[j];
+
+    batch->lanes[lane].setup = setup;
+}
+
+void
+batchRun(Batch * batch, const EpisodeScenario * scenario, EpisodeResult results[])
+{
+    reset(batch);
+
+    for (float time = 0.0f; time < scenario->warmTime; time += FRAME)
+    {
+        frame(batch, scenario->warmTarget);
+    }
+
+    EpisodeScore * scores = malloc(batch->count * sizeof(EpisodeScore));
+    for (unsigned int i = 0; i < batch->count; i++)
+    {
+        episodeScoreStart(&scores[i], scenario, blockOf(batch, i)->measured[i % WIDTH]);
+    }
+    if (scenario->sag != 0.0f)
+    {
+        for (unsigned int i = 0; i < batch->blockCount * WIDTH; i++)
+        {
+            blockOf(batch, i)->battery[i % WIDTH] =
+                batch->lanes[i].setup.batteryVoltage - scenario->sag;
+        }
+    }
+
+    int shots = 0;
+    for (float time = 0.0f; time < scenario->time; time += FRAME)
+    {
+        while (shots < scenario->shots && time >= shots * scenario->shotPeriod)
+        {
+            shoot(batch);
+            shots++;
+        }
+
+        frame(batch, scenario->target);
+        for (unsigned int i = 0; i < batch->count; i++)
+        {
+            BatchBlock * block = blockOf(batch, i);
+            ControlSystem system =
+            {
+                .target = scenario->target,
+                .measured = block->measured[i % WIDTH],
+                .derivative = block->derivative[i % WIDTH]
+            };
+            episodeScoreFrame(&scores[i], time, &system);
+        }
+    }
+
+    for (unsigned int i = 0; i < batch->count; i++)
+    {
+        results[i] = episodeScoreFinish(&scores[i]);
+    }
+    free(scores);
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+reset(Batch * batch)
+{
+    for (unsigned int i = 0; i < batch->blockCount; i++)
+    {
+        BatchBlock * block = &batch->blocks[i];
+        Floats zero = {0};
+        block->command = zero;
+        block->speed = zero;
+        block->shotTorque = zero;
+        block->shotRemaining = zero;
+        block->angle = (Doubles){0};
+        block->reading = zero;
+        block->measured = zero;
+        block->derivative = zero;
+        block->integral = zero;
+        block->action = zero;
+    }
+    for (unsigned int i = 0; i < batch->blockCount * WIDTH; i++)
+    {
+        BatchLane * lane = &batch->lanes[i];
+        blockOf(batch, i)->battery[i % WIDTH] = lane->setup.batteryVoltage;
+        lane->readTicks = 0;
+        lane->random = lane->setup.seed != 0? lane->setup.seed : 1;
+    }
+    batch->time = 0.0;
+    batch->readTime = 0.0;
+}
+
+// As episode.c's frame: sense, filter, control, actuate, then let the
+// plants run until the next.
+static void
+frame(Batch * batch, float target)
+{
+    sense(batch);
+    for (unsigned int i = 0; i < batch->blockCount; i++)
+    {
+        control(&batch->blocks[i], batch->law, target);
+        step(&batch->blocks[i], FRAME);
+    }
+
+    // Plant time, summed as plantStep sums it
+    float dt = FRAME;
+    while (dt > 0.0f)
+    {
+        float h = dt < STEP? dt : STEP;
+        batch->time += h;
+        dt -= h;
+    }
+}
+
+// plantEncoderGetter, lane by lane, the noise not vectorising.
+static void
+sense(Batch * batch)
+{
+    float minutes = (batch->time - batch->readTime) / 60.0f;
+    for (unsigned int i = 0; i < batch->blockCount * WIDTH; i++)
+    {
+        BatchLane * lane = &batch->lanes[i];
+        BatchBlock * block = blockOf(batch, i);
+        float ticksPerRev = lane->setup.ticksPerRev;
+
+        double ticks = floor(block->angle[i % WIDTH] * ticksPerRev);
+        if (lane->setup.encoderNoise > 0.0f)
+        {
+            ticks += floor(gaussian(lane) * lane->setup.encoderNoise + 0.5f);
+        }
+
+        float rpm = 0.0f;
+        if (minutes > 0.0f) rpm = ((long)ticks - lane->readTicks) / ticksPerRev / minutes;
+        lane->readTicks = (long)ticks;
+        block->reading[i % WIDTH] = rpm;
+    }
+    batch->readTime = batch->time;
+}
+
+// plantShoot
+static void
+shoot(Batch * batch)
+{
+    for (unsigned int i = 0; i < batch->blockCount; i++)
+    {
+        BatchBlock * block = &batch->blocks[i];
+        Ints shooting = block->shotDuration > 0.0f;
+        Floats torque = block->inertia * ABSOLUTE(block->speed) * block->shotLoss / block->shotDuration;
+        block->shotTorque = SELECT(shooting, block->shotTorque + torque, block->shotTorque);
+        block->shotRemaining = SELECT(shooting, block->shotDuration, block->shotRemaining);
+    }
+}
+
+// lowPassUpdate, then the law's update, then the clamp and plantMotorSetter.
+KERNEL static void
+control(BatchBlock * block, BatchLaw law, float target)
+{
+    float dt = FRAME;
+    float rate = dt / EPISODE_SMOOTHING;
+
+    Floats measureChange = block->reading - block->measured;
+    measureChange *= rate;
+    Floats derivative = measureChange / dt;
+    Floats derivativeChange = derivative - block->derivative;
+    derivativeChange *= rate;
+    block->measured += measureChange;
+    block->derivative += derivativeChange;
+
+    Floats error = block->measured - target;
+    Floats action = block->action;
+    Floats * gains = block->gains;
+    switch (law)
+    {
+        case BATCH_LAW_PID:
+            block->integral += error * dt;
+            action = -(gains[0] * error + gains[1] * block->integral + gains[2] * block->derivative);
+            break;
+
+        case BATCH_LAW_TBH:
+        {
+            Floats actionDiff = -error * gains[0];
+            actionDiff = SELECT(
+                actionDiff > gains[1],
+                gains[1],
+                SELECT(actionDiff < -gains[1], -gains[1], actionDiff)
+            );
+            action += actionDiff * dt;
+            break;
+        }
+
+        case BATCH_LAW_BANGBANG:
+            action = SELECT(error > gains[2], gains[1], SELECT(error < gains[3], gains[0], action));
+            break;
+    }
+
+    action = SELECT(action > 127.0f, (Floats){0} + 127.0f, action);
+    action = SELECT(action < -127.0f, (Floats){0} - 127.0f, action);
+    block->action = action;
+
+    Ints command = __builtin_convertvector(action, Ints);
+    block->command = __builtin_convertvector(command, Floats) / 127.0f;
+}
+
+// plantStep, and plant.c's step with its branches as selects.
+KERNEL static void
+step(BatchBlock * block, float dt)
+{
+    float radiansPerRev = SHIM_RADIANS_PER_REV;
+    while (dt > 0.0f)
+    {
+        float h = dt < STEP? dt : STEP;
+        Floats zero = {0};
+        Floats count = block->motorCount;
+        Floats u = block->command;
+        Floats motorSpeed = block->speed / block->ratio;
+        Floats backEmf = block->speedConstant * motorSpeed;
+
+        Floats sag = block->sag;
+        Floats voltage = (block->battery + sag * u * backEmf) / (1.0f + sag * u * u);
+        Floats motorCurrent = (u * voltage - backEmf) / block->resistance;
+
+        Floats driveTorque = count * block->torqueConstant * motorCurrent / block->ratio;
+
+        Ints shooting = block->shotRemaining > 0.0f;
+        Floats shotTorque = SELECT(shooting, block->shotTorque, zero);
+        Floats shotRemaining = block->shotRemaining - h;
+        block->shotRemaining = SELECT(shooting, shotRemaining, block->shotRemaining);
+        block->shotTorque = SELECT(shooting & (shotRemaining <= 0.0f), zero, block->shotTorque);
+
+        Floats speed = block->speed;
+        shotTorque = SELECT(speed < 0.0f, -shotTorque, shotTorque);
+
+        // frictionTorque
+        Floats coulomb = block->frictionCoulomb;
+        Floats held = SELECT(
+            ABSOLUTE(driveTorque) <= coulomb,
+            driveTorque,
+            SELECT(driveTorque > 0.0f, coulomb, -coulomb)
+        );
+        Floats magnitude =
+            coulomb +
+            block->frictionViscous * ABSOLUTE(speed) +
+            block->frictionDrag * speed * speed;
+        Floats friction = SELECT(
+            speed == 0.0f,
+            held,
+            SELECT(speed > 0.0f, magnitude, -magnitude)
+        );
+
+        Floats torque = driveTorque - friction - shotTorque;
+        Floats newSpeed = speed + torque / block->inertia * h;
+
+        Ints reversed = ((speed > 0.0f) & (newSpeed < 0.0f)) | ((speed < 0.0f) & (newSpeed > 0.0f));
+        newSpeed = SELECT(reversed, zero, newSpeed);
+
+        block->angle += __builtin_convertvector(newSpeed * h / radiansPerRev, Doubles);
+        block->speed = newSpeed;
+
+        dt -= h;
+    }
+}
+
+static BatchBlock *
+blockOf(Batch * batch, unsigned int lane)
+{
+    return &batch->blocks[lane / WIDTH];
+}
+
+// As plant.c, so that each lane draws the same noise as its plant would.
+static float
+gaussian(BatchLane * lane)
+{
+    float u1 = (nextRandom(lane) + 1.0f) / 4294967296.0f;
+    float u2 = nextRandom(lane) / 4294967296.0f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(SHIM_RADIANS_PER_REV * u2);
+}
+
+// xorshift32
+static unsigned int
+nextRandom(BatchLane * lane)
+{
+    unsigned int x = lane->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    lane->random = x;
+    return x;
+}
+
+// }}}
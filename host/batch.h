@@ -0,0 +1,79 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include "plant.h"
+#include "episode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Lanes per vector; batches are padded up to a multiple of this.
+#define BATCH_WIDTH 8
+#define BATCH_NUMOFGAINS 4
+
+
+
+// Typedefs {{{
+
+struct Batch;
+typedef struct Batch Batch;
+
+// The update laws of src/control.c. Gains are in the order their Init
+// functions take them: p, i, d; gain, slew; action high, action low,
+// trigger high, trigger low.
+typedef enum
+BatchLaw
+{
+    BATCH_LAW_PID,
+    BATCH_LAW_TBH,
+    BATCH_LAW_BANGBANG
+}
+BatchLaw;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Many flywheels, each with its own plant and gains but all under the same
+// law, run through a scenario in lock step. State is kept a field at a
+// time across lanes, and the plant and controller are updated BATCH_WIDTH
+// lanes at once with vector arithmetic, in the same order of operations as
+// plant.c and control.c, so that each lane tracks what episodeRun would
+// give it. Where the target has them, the kernels are also built for AVX2
+// and picked at load time.
+//
+// Lanes start on the default plant with zero gains.
+//
+Batch *
+batchInit(BatchLaw, unsigned int count);
+
+void
+batchDelete(Batch*);
+
+void
+batchSetLane(Batch*, unsigned int lane, PlantSetup, const float gains[BATCH_NUMOFGAINS]);
+
+//
+// Runs the scenario from rest, as episodeRun does, for every lane. Only
+// cpu is left zero in the results, the batch not being timed lane by lane.
+//
+void
+batchRun(Batch*, const EpisodeScenario*, EpisodeResult results[]);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,210 @@
+#include "episode.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "plant.h"
+#include "control.h"
+
+
+#define FRAME EPISODE_FRAME
+#define UNUSED(x) (void)(x)
+
+
+// Private functions, forward declarations {{{
+
+static void frame(
+    Plant*,
+    ControlSystem*,
+    ControlHandle filter,
+    ControlHandle,
+    ControlUpdater,
+    double * cpu
+);
+static double cpuNow();
+
+const EpisodeScenario EPISODE_SCENARIOS[EPISODE_NUMOFSCENARIOS] =
+{
+    {"step-up", 0.0f, 0.0f, 1500.0f, 0.0f, 0, 0.0f, 10.0f},
+    {"step-down", 2000.0f, 10.0f, 1200.0f, 0.0f, 0, 0.0f, 10.0f},
+    {"shots", 1500.0f, 10.0f, 1500.0f, 0.0f, 4, 1.0f, 10.0f},
+    {"sag", 1500.0f, 10.0f, 1500.0f, 1.0f, 0, 0.0f, 10.0f}
+};
+
+// }}}
+
+
+
+// Public methods {{{
+
+EpisodeResult
+episodeRun(
+    ControlHandle control,
+    ControlUpdater update,
+    ControlResetter reset,
+    const EpisodeScenario * scenario,
+    PlantSetup plantSetup
+){
+    Plant * plant = plantInit(plantSetup);
+    ControlHandle filter = lowPassInit(EPISODE_SMOOTHING);
+    ControlSystem system = {0};
+    double cpu = 0.0;
+    if (reset != NULL) reset(control);
+
+    system.target = scenario->warmTarget;
+    for (float time = 0.0f; time < scenario->warmTime; time += FRAME)
+    {
+        frame(plant, &system, filter, control, update, &cpu);
+    }
+
+    system.target = scenario->target;
+    if (scenario->sag != 0.0f)
+    {
+        plantSetBattery(plant, plantSetup.batteryVoltage - scenario->sag);
+    }
+
+    EpisodeScore score;
+    episodeScoreStart(&score, scenario, system.measured);
+    int shots = 0;
+    cpu = 0.0;
+
+    for (float time = 0.0f; time < scenario->time; time += FRAME)
+    {
+        while (shots < scenario->shots && time >= shots * scenario->shotPeriod)
+        {
+            plantShoot(plant);
+            shots++;
+        }
+
+        frame(plant, &system, filter, control, update, &cpu);
+        episodeScoreFrame(&score, time, &system);
+    }
+    EpisodeResult result = episodeScoreFinish(&score);
+    result.cpu = cpu / score.frames;
+
+    plantDelete(plant);
+    free(filter);
+    return result;
+}
+
+void
+episodeScoreStart(EpisodeScore * score, const EpisodeScenario * scenario, float measured)
+{
+    score->scenario = scenario;
+    score->start = measured;
+    score->step = scenario->target - measured;
+    score->isStep = scenario->target != scenario->warmTarget;
+    score->inBand = false;
+    score->frames = 0;
+
+    EpisodeResult result =
+    {
+        .rise = -1.0f,
+        .overshoot = 0.0f,
+        .settle = 0.0f,
+        .iae = 0.0f,
+        .cpu = 0.0
+    };
+    score->result = result;
+}
+
+void
+episodeScoreFrame(EpisodeScore * score, float time, const ControlSystem * system)
+{
+    EpisodeResult * result = &score->result;
+    float step = score->step;
+    float error = system->measured - system->target;
+    result->iae += fabsf(error) * FRAME;
+    score->frames++;
+
+    bool risen = (system->measured - score->start) * step >= 0.9f * step * step;
+    if (score->isStep && result->rise < 0.0f && risen) result->rise = time + FRAME;
+    if (!score->isStep || result->rise >= 0.0f)
+    {
+        float past = score->isStep? (step > 0.0f? error : -error) : fabsf(error);
+        if (past > result->overshoot) result->overshoot = past;
+    }
+
+    bool inBand =
+        fabsf(error) < EPISODE_THRESHOLDERROR &&
+        fabsf(system->derivative) < EPISODE_THRESHOLDDERIVATIVE;
+    if (inBand && !score->inBand) result->settle = time + FRAME;
+    score->inBand = inBand;
+}
+
+EpisodeResult
+episodeScoreFinish(EpisodeScore * score)
+{
+    if (!score->inBand) score->result.settle = -1.0f;
+    return score->result;
+}
+
+const EpisodeScenario *
+episodeFindScenario(const char * name)
+{
+    for (int i = 0; i < EPISODE_NUMOFSCENARIOS; i++)
+    {
+        if (strcmp(EPISODE_SCENARIOS[i].name, name) == 0) return &EPISODE_SCENARIOS[i];
+    }
+    return NULL;
+}
+
+float
+episodeEstimator(float target)
+{
+    if (target <= 0.0f) return 0.0f;
+    return 18.195f + 2.2052e-5f * target * target;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+// One flywheel frame: sense, filter, control, actuate, then let the plant
+// run until the next.
+static void
+frame(
+    Plant * plant,
+    ControlSystem * system,
+    ControlHandle filter,
+    ControlHandle control,
+    ControlUpdater update,
+    double * cpu
+){
+    system->dt = FRAME;
+    system->measured = plantEncoderGetter(plant).rpm;
+    lowPassUpdate(filter, system);
+
+    double start = cpuNow();
+    update(control, system);
+    *cpu += cpuNow() - start;
+
+    if (system->action > 127.0f) system->action = 127.0f;
+    if (system->action < -127.0f) system->action = -127.0f;
+    plantMotorSetter(plant, (int)system->action);
+    plantStep(plant, FRAME);
+}
+
+static double
+cpuNow()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
+#endif
+}
+
+// }}}
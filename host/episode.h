@@ -0,0 +1,134 @@
+#ifndef EPISODE_H_
+#define EPISODE_H_
+
+#include <stdbool.h>
+#include "plant.h"
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// As the flywheel runs on the robot (see src/init.c)
+#define EPISODE_FRAME 0.06f
+#define EPISODE_SMOOTHING 0.2f
+#define EPISODE_THRESHOLDERROR 10.0f
+#define EPISODE_THRESHOLDDERIVATIVE 100.0f
+
+#define EPISODE_NUMOFSCENARIOS 4
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EPISODE_CPUUNIT "cycles"
+#else
+#define EPISODE_CPUUNIT "ns"
+#endif
+
+
+
+// Typedefs {{{
+
+// Runs at the warm up target for the warm up time unscored, then is
+// scored from the change to the target, the battery sagging by some volts,
+// and shots.
+typedef struct
+EpisodeScenario
+{
+    char * name;
+    float warmTarget;
+    float warmTime;
+    float target;
+    float sag;
+    int shots;
+    float shotPeriod;
+    float time;
+}
+EpisodeScenario;
+
+// Times in seconds from the start of scoring, negative if never; rpm;
+// rpm seconds; CPU per controller update.
+//
+// Rise is to 90% of a step. Overshoot is how far past the target the
+// flywheel goes after rising, or for a disturbance, how far off the target
+// it is pushed. Settle is when the flywheel last entered the readiness
+// band, holding there to the end.
+typedef struct
+EpisodeResult
+{
+    float rise;
+    float overshoot;
+    float settle;
+    float iae;
+    double cpu;
+}
+EpisodeResult;
+
+// Scoring partway through an episode.
+typedef struct
+EpisodeScore
+{
+    const EpisodeScenario * scenario;
+    float start;
+    float step;
+    bool isStep;
+    bool inBand;
+    int frames;
+    EpisodeResult result;
+}
+EpisodeScore;
+
+// }}}
+
+
+
+// Methods {{{
+
+extern const EpisodeScenario EPISODE_SCENARIOS[EPISODE_NUMOFSCENARIOS];
+
+//
+// One scenario with the controller closed around a plant behind the
+// robot's low pass filter, as the flywheel task runs it. Episodes share
+// nothing, so any number can run at once.
+//
+EpisodeResult
+episodeRun(
+    ControlHandle,
+    ControlUpdater,
+    ControlResetter,
+    const EpisodeScenario*,
+    PlantSetup
+);
+
+//
+// episodeRun's scoring, for runners of their own: start once the scenario
+// takes over from the warm up, at the measured speed then, and score each
+// frame after it has run.
+//
+void
+episodeScoreStart(EpisodeScore*, const EpisodeScenario*, float measured);
+
+void
+episodeScoreFrame(EpisodeScore*, float time, const ControlSystem*);
+
+EpisodeResult
+episodeScoreFinish(EpisodeScore*);
+
+const EpisodeScenario *
+episodeFindScenario(const char * name);
+
+// Same model as the robot's flywheel estimator.
+float
+episodeEstimator(float target);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,107 @@
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdbool.h>
+#include <API.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define HOST_NUMOFMOTORS 10
+#define HOST_NUMOFDIGITAL 12
+#define HOST_NUMOFANALOG 8
+#define HOST_NUMOFIMES (IME_ADDR_MAX + 1)
+#define HOST_NUMOFJOYSTICKS 2
+
+
+
+// Methods {{{
+
+//
+// The simulated side of the robot, for whatever drives the firmware on the
+// host: motor outputs can be read back and sensor inputs set. Ports are
+// numbered as on the Cortex, and out of range ports are ignored.
+//
+
+// Tasks {{{
+
+//
+// Tasks run one at a time on a discrete-event scheduler, highest priority
+// first, and time only passes when every task is waiting on it: a run is
+// repeatable to the byte, and as fast as the code allows. Real time paces
+// the virtual clock to the wall clock instead, for interactive use.
+//
+// Call once, before anything else; the calling thread becomes a task.
+//
+void
+hostKernelInit(bool realTime);
+
+bool
+hostKernelIsRealTime();
+
+// }}}
+
+// Motors and power {{{
+
+int
+hostMotorGet(unsigned char channel);
+
+void
+hostPowerLevelSet(unsigned int millivolts);
+
+// }}}
+
+// Sensors {{{
+
+//
+// Encoders are keyed by their top port. Ticks are in the encoder's own
+// direction, before encoderInit's reverse flag is applied.
+//
+void
+hostEncoderAdd(unsigned char portTop, int ticks);
+
+void
+hostImeSet(unsigned char address, int count, int velocity);
+
+void
+hostAnalogSet(unsigned char channel, int value);
+
+void
+hostDigitalSet(unsigned char pin, bool value);
+
+// Gyros are keyed by their analog port, ultrasonics by their echo port.
+// An ultrasonic reading of zero has found nothing.
+void
+hostGyroSet(unsigned char port, int degrees);
+
+void
+hostUltrasonicSet(unsigned char portEcho, int centimeters);
+
+// }}}
+
+// Joysticks {{{
+
+void
+hostJoystickSetDigital(
+    unsigned char joystick,
+    unsigned char buttonGroup,
+    unsigned char button,
+    bool pressed
+);
+
+// }}}
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,505 @@
+#include "host.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+
+
+#define NUMOFMOTORS HOST_NUMOFMOTORS
+#define NUMOFDIGITAL HOST_NUMOFDIGITAL
+#define NUMOFANALOG HOST_NUMOFANALOG
+#define NUMOFIMES HOST_NUMOFIMES
+#define NUMOFJOYSTICKS HOST_NUMOFJOYSTICKS
+#define NUMOFGROUPS 4
+#define INPUTPOLL 10
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+HostEncoder
+{
+    unsigned char portTop;
+    bool reverse;
+    volatile int zero;
+}
+HostEncoder;
+
+typedef struct
+HostIme
+{
+    volatile int count;
+    volatile int velocity;
+    volatile int zero;
+}
+HostIme;
+
+typedef struct
+HostGyro
+{
+    volatile int degrees;
+    volatile int zero;
+}
+HostGyro;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static bool isReadable(FILE*);
+static void blockForever();
+
+// }}}
+
+
+
+// Private state {{{
+
+static volatile int motors[NUMOFMOTORS];
+static volatile unsigned int powerLevel = 7200;
+
+static volatile bool digital[NUMOFDIGITAL] =
+{
+    // Inputs are pulled up.
+    true, true, true, true, true, true, true, true, true, true, true, true
+};
+static volatile int encoderTicks[NUMOFDIGITAL];
+static HostEncoder * encoders[NUMOFDIGITAL];
+
+static volatile int analog[NUMOFANALOG];
+static volatile int analogCalibration[NUMOFANALOG];
+static HostGyro gyros[NUMOFANALOG];
+
+static volatile int ultrasonics[NUMOFDIGITAL];
+
+static HostIme imes[NUMOFIMES];
+static volatile unsigned int imeCount = 0;
+
+static volatile unsigned char joysticks[NUMOFJOYSTICKS][NUMOFGROUPS];
+
+// }}}
+
+
+
+// Host methods {{{
+
+int
+hostMotorGet(unsigned char channel)
+{
+    return motorGet(channel);
+}
+
+void
+hostPowerLevelSet(unsigned int millivolts)
+{
+    powerLevel = millivolts;
+}
+
+void
+hostEncoderAdd(unsigned char portTop, int ticks)
+{
+    if (portTop < 1 || portTop > NUMOFDIGITAL) return;
+    encoderTicks[portTop - 1] += ticks;
+}
+
+void
+hostImeSet(unsigned char address, int count, int velocity)
+{
+    if (address >= NUMOFIMES) return;
+    imes[address].count = count;
+    imes[address].velocity = velocity;
+    if (address >= imeCount) imeCount = address + 1;
+}
+
+void
+hostAnalogSet(unsigned char channel, int value)
+{
+    if (channel < 1 || channel > NUMOFANALOG) return;
+    analog[channel - 1] = value;
+}
+
+void
+hostGyroSet(unsigned char port, int degrees)
+{
+    if (port < 1 || port > NUMOFANALOG) return;
+    gyros[port - 1].degrees = degrees;
+}
+
+void
+hostUltrasonicSet(unsigned char portEcho, int centimeters)
+{
+    if (portEcho < 1 || portEcho > NUMOFDIGITAL) return;
+    ultrasonics[portEcho - 1] = centimeters;
+}
+
+void
+hostDigitalSet(unsigned char pin, bool value)
+{
+    if (pin < 1 || pin > NUMOFDIGITAL) return;
+    digital[pin - 1] = value;
+}
+
+void
+hostJoystickSetDigital(
+    unsigned char joystick,
+    unsigned char buttonGroup,
+    unsigned char button,
+    bool pressed
+){
+    if (joystick < 1 || joystick > NUMOFJOYSTICKS) return;
+    if (buttonGroup < 5 || buttonGroup > 8) return;
+    volatile unsigned char * buttons = &joysticks[joystick - 1][buttonGroup - 5];
+    if (pressed) *buttons |= button;
+    else *buttons &= ~button;
+}
+
+// }}}
+
+
+
+// Competition {{{
+
+bool
+isAutonomous()
+{
+    return false;
+}
+
+bool
+isEnabled()
+{
+    return true;
+}
+
+bool
+isJoystickConnected(unsigned char joystick)
+{
+    return joystick >= 1 && joystick <= NUMOFJOYSTICKS;
+}
+
+bool
+isOnline()
+{
+    return false;
+}
+
+int
+joystickGetAnalog(unsigned char joystick, unsigned char axis)
+{
+    UNUSED(joystick);
+    UNUSED(axis);
+    return 0;
+}
+
+bool
+joystickGetDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char button)
+{
+    if (joystick < 1 || joystick > NUMOFJOYSTICKS) return false;
+    if (buttonGroup < 5 || buttonGroup > 8) return false;
+    return (joysticks[joystick - 1][buttonGroup - 5] & button) != 0;
+}
+
+unsigned int
+powerLevelBackup()
+{
+    return 0;
+}
+
+unsigned int
+powerLevelMain()
+{
+    return powerLevel;
+}
+
+// }}}
+
+
+
+// Basic I/O {{{
+
+int
+analogCalibrate(unsigned char channel)
+{
+    if (channel < 1 || channel > NUMOFANALOG) return 0;
+    analogCalibration[channel - 1] = analog[channel - 1];
+    return analogCalibration[channel - 1];
+}
+
+int
+analogRead(unsigned char channel)
+{
+    if (channel < 1 || channel > NUMOFANALOG) return 0;
+    return analog[channel - 1];
+}
+
+int
+analogReadCalibrated(unsigned char channel)
+{
+    if (channel < 1 || channel > NUMOFANALOG) return 0;
+    return analog[channel - 1] - analogCalibration[channel - 1];
+}
+
+int
+analogReadCalibratedHR(unsigned char channel)
+{
+    return analogReadCalibrated(channel) * 16;
+}
+
+bool
+digitalRead(unsigned char pin)
+{
+    if (pin < 1 || pin > NUMOFDIGITAL) return false;
+    return digital[pin - 1];
+}
+
+void
+digitalWrite(unsigned char pin, bool value)
+{
+    hostDigitalSet(pin, value);
+}
+
+void
+pinMode(unsigned char pin, unsigned char mode)
+{
+    UNUSED(pin);
+    UNUSED(mode);
+}
+
+int
+motorGet(unsigned char channel)
+{
+    if (channel < 1 || channel > NUMOFMOTORS) return 0;
+    return motors[channel - 1];
+}
+
+void
+motorSet(unsigned char channel, int speed)
+{
+    if (channel < 1 || channel > NUMOFMOTORS) return;
+    if (speed > 127) speed = 127;
+    if (speed < -127) speed = -127;
+    motors[channel - 1] = speed;
+}
+
+void
+motorStop(unsigned char channel)
+{
+    motorSet(channel, 0);
+}
+
+void
+motorStopAll()
+{
+    for (int i = 1; i <= NUMOFMOTORS; i++) motorStop(i);
+}
+
+// }}}
+
+
+
+// Integrated motor encoders {{{
+
+unsigned int
+imeInitializeAll()
+{
+    return imeCount;
+}
+
+bool
+imeGet(unsigned char address, int * value)
+{
+    if (address >= imeCount) return false;
+    *value = imes[address].count - imes[address].zero;
+    return true;
+}
+
+bool
+imeGetVelocity(unsigned char address, int * value)
+{
+    if (address >= imeCount) return false;
+    *value = imes[address].velocity;
+    return true;
+}
+
+bool
+imeReset(unsigned char address)
+{
+    if (address >= imeCount) return false;
+    imes[address].zero = imes[address].count;
+    return true;
+}
+
+void
+imeShutdown()
+{
+    imeCount = 0;
+}
+
+// }}}
+
+
+
+// Sensors {{{
+
+Encoder
+encoderInit(unsigned char portTop, unsigned char portBottom, bool reverse)
+{
+    UNUSED(portBottom);
+    if (portTop < 1 || portTop > NUMOFDIGITAL) return NULL;
+    if (encoders[portTop - 1] != NULL) return NULL;
+
+    HostEncoder * encoder = malloc(sizeof(HostEncoder));
+    encoder->portTop = portTop;
+    encoder->reverse = reverse;
+    encoder->zero = encoderTicks[portTop - 1];
+    encoders[portTop - 1] = encoder;
+    return encoder;
+}
+
+int
+encoderGet(Encoder handle)
+{
+    if (handle == NULL) return 0;
+    HostEncoder * encoder = handle;
+    int ticks = encoderTicks[encoder->portTop - 1] - encoder->zero;
+    return encoder->reverse? -ticks : ticks;
+}
+
+void
+encoderReset(Encoder handle)
+{
+    if (handle == NULL) return;
+    HostEncoder * encoder = handle;
+    encoder->zero = encoderTicks[encoder->portTop - 1];
+}
+
+void
+encoderShutdown(Encoder handle)
+{
+    if (handle == NULL) return;
+    HostEncoder * encoder = handle;
+    encoders[encoder->portTop - 1] = NULL;
+    free(encoder);
+}
+
+Gyro
+gyroInit(unsigned char port, unsigned short multiplier)
+{
+    UNUSED(multiplier);
+    if (port < 1 || port > NUMOFANALOG) return NULL;
+    HostGyro * gyro = &gyros[port - 1];
+    gyro->zero = gyro->degrees;
+    return gyro;
+}
+
+int
+gyroGet(Gyro handle)
+{
+    if (handle == NULL) return 0;
+    HostGyro * gyro = handle;
+    return gyro->degrees - gyro->zero;
+}
+
+void
+gyroReset(Gyro handle)
+{
+    if (handle == NULL) return;
+    HostGyro * gyro = handle;
+    gyro->zero = gyro->degrees;
+}
+
+void
+gyroShutdown(Gyro gyro)
+{
+    UNUSED(gyro);
+}
+
+Ultrasonic
+ultrasonicInit(unsigned char portEcho, unsigned char portPing)
+{
+    UNUSED(portPing);
+    if (portEcho < 1 || portEcho > NUMOFDIGITAL) return NULL;
+    return (int *)&ultrasonics[portEcho - 1];
+}
+
+int
+ultrasonicGet(Ultrasonic ultrasonic)
+{
+    if (ultrasonic == NULL) return 0;
+    return *(volatile int *)ultrasonic;
+}
+
+void
+ultrasonicShutdown(Ultrasonic ultrasonic)
+{
+    UNUSED(ultrasonic);
+}
+
+// }}}
+
+
+
+// Character I/O {{{
+
+void
+lcdInit(FILE * lcdPort)
+{
+    UNUSED(lcdPort);
+}
+
+// Not the macro, which would call itself.
+#undef fgets
+
+char *
+hostFgets(char * buffer, int maxSize, FILE * stream)
+{
+    if (stream == NULL) blockForever();
+
+    // Only read once a line is waiting, so that the rest of the robot
+    // keeps running in real time. In virtual time, reading stops the clock.
+    while (hostKernelIsRealTime() && !isReadable(stream)) delay(INPUTPOLL);
+
+    if (fgets(buffer, maxSize, stream) == NULL) blockForever();
+
+    if (buffer[0] == '@')
+    {
+        char * line;
+        unsigned long sendTime = strtoul(buffer + 1, &line, 10);
+        if (*line == ' ') line++;
+        memmove(buffer, line, strlen(line) + 1);
+
+        unsigned long time = millis();
+        if (sendTime > time) delay(sendTime - time);
+    }
+    return buffer;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static bool
+isReadable(FILE * stream)
+{
+    struct pollfd file =
+    {
+        .fd = fileno(stream),
+        .events = POLLIN
+    };
+    return poll(&file, 1, 0) > 0;
+}
+
+static void
+blockForever()
+{
+    while (true) delay(60000);
+}
+
+// }}}
@@ -0,0 +1,579 @@
+#include "host.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+
+#define MAXTASKS 32
+#define FOREVER ((unsigned long)-1)
+#define NEVER ((unsigned long long)-1)
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef enum
+HostTaskState
+{
+    READY,
+    RUNNING,
+    SLEEPING,
+    BLOCKED,
+    DEAD
+}
+HostTaskState;
+
+struct HostLock;
+typedef struct HostLock HostLock;
+
+struct HostTask;
+typedef struct HostTask HostTask;
+
+struct HostTask
+{
+    pthread_t thread;
+    pthread_cond_t turn;
+    TaskCode code;
+    void * parameters;
+    unsigned int priority;
+
+    HostTaskState state;
+    unsigned long long readyOrder;
+    unsigned long long wakeTime;
+
+    HostLock * blockedOn;
+    bool taken;
+    HostTask * nextWaiter;
+};
+
+// Mutexes and (binary) semaphores behave the same here: a take blocks
+// until the lock is available, and a give fails if it already is. Waiters
+// are woken highest priority first, then first come first served.
+// Priority inheritance is not simulated.
+struct HostLock
+{
+    bool isAvailable;
+    HostTask * waiters;
+};
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void * runTask(void * task);
+static HostTask * createTask(TaskCode, void * parameters, unsigned int priority);
+static void makeReady(HostTask*);
+static void preempt(HostTask * self);
+static void schedule(HostTask * self);
+static void handOff();
+static HostTask * nextReady();
+static bool advanceTime();
+static void sleepTask(HostTask * self, unsigned long long wakeTime);
+static HostLock * lockCreate();
+static bool lockTake(HostLock*, unsigned long blockTime);
+static bool lockGive(HostLock*);
+static void lockDelete(HostLock*);
+static void addWaiter(HostLock*, HostTask*);
+static void removeWaiter(HostLock*, HostTask*);
+static unsigned long long wallMicros();
+static void sleepUntilWall(unsigned long long microTime);
+
+// Only the task holding the baton (current) runs; the kernel mutex guards
+// the hand over.
+static pthread_mutex_t kernel = PTHREAD_MUTEX_INITIALIZER;
+static HostTask * tasks[MAXTASKS];
+static int taskCount = 0;
+static HostTask * current = NULL;
+static unsigned long long readyCount = 0;
+
+static volatile unsigned long long now = 0;
+static bool realTime = false;
+static unsigned long long wallStart = 0;
+
+// }}}
+
+
+
+// Host methods {{{
+
+void
+hostKernelInit(bool isRealTime)
+{
+    realTime = isRealTime;
+    wallStart = wallMicros();
+    now = 0;
+
+    // The calling thread becomes the first task, as if it were the
+    // Cortex's own user task.
+    HostTask * self = createTask(NULL, NULL, TASK_PRIORITY_DEFAULT);
+    self->thread = pthread_self();
+    self->state = RUNNING;
+    current = self;
+}
+
+bool
+hostKernelIsRealTime()
+{
+    return realTime;
+}
+
+// }}}
+
+
+
+// Tasks {{{
+
+TaskHandle
+taskCreate(
+    TaskCode taskCode,
+    const unsigned int stackDepth,
+    void * parameters,
+    const unsigned int priority
+){
+    UNUSED(stackDepth);
+    pthread_mutex_lock(&kernel);
+    HostTask * task = createTask(taskCode, parameters, priority);
+    if (task == NULL)
+    {
+        pthread_mutex_unlock(&kernel);
+        return NULL;
+    }
+    if (pthread_create(&task->thread, NULL, runTask, task) != 0)
+    {
+        task->state = DEAD;
+        pthread_mutex_unlock(&kernel);
+        return NULL;
+    }
+    pthread_detach(task->thread);
+
+    makeReady(task);
+    preempt(current);
+    pthread_mutex_unlock(&kernel);
+    return task;
+}
+
+unsigned int
+taskGetCount()
+{
+    pthread_mutex_lock(&kernel);
+    unsigned int count = 0;
+    for (int i = 0; i < taskCount; i++)
+    {
+        if (tasks[i]->state != DEAD) count++;
+    }
+    pthread_mutex_unlock(&kernel);
+    return count;
+}
+
+unsigned int
+taskPriorityGet(TaskHandle handle)
+{
+    HostTask * task = handle == NULL? current : handle;
+    return task->priority;
+}
+
+void
+taskPrioritySet(TaskHandle handle, const unsigned int priority)
+{
+    pthread_mutex_lock(&kernel);
+    HostTask * task = handle == NULL? current : handle;
+    task->priority = priority;
+    preempt(current);
+    pthread_mutex_unlock(&kernel);
+}
+
+// }}}
+
+
+
+// Timing {{{
+
+unsigned long
+micros()
+{
+    return now;
+}
+
+unsigned long
+millis()
+{
+    return now / 1000;
+}
+
+void
+taskDelay(const unsigned long time)
+{
+    pthread_mutex_lock(&kernel);
+    sleepTask(current, now + time * 1000ULL);
+    pthread_mutex_unlock(&kernel);
+}
+
+void
+taskDelayUntil(unsigned long * previousWakeTime, const unsigned long cycleTime)
+{
+    pthread_mutex_lock(&kernel);
+    *previousWakeTime += cycleTime;
+    sleepTask(current, *previousWakeTime * 1000ULL);
+    pthread_mutex_unlock(&kernel);
+}
+
+void
+delay(const unsigned long time)
+{
+    taskDelay(time);
+}
+
+void
+wait(const unsigned long time)
+{
+    taskDelay(time);
+}
+
+void
+waitUntil(unsigned long * previousWakeTime, const unsigned long time)
+{
+    taskDelayUntil(previousWakeTime, time);
+}
+
+void
+delayMicroseconds(const unsigned long time)
+{
+    pthread_mutex_lock(&kernel);
+    sleepTask(current, now + time);
+    pthread_mutex_unlock(&kernel);
+}
+
+// }}}
+
+
+
+// Semaphores and mutexes {{{
+
+Semaphore
+semaphoreCreate()
+{
+    return lockCreate();
+}
+
+bool
+semaphoreGive(Semaphore semaphore)
+{
+    return lockGive(semaphore);
+}
+
+bool
+semaphoreTake(Semaphore semaphore, const unsigned long blockTime)
+{
+    return lockTake(semaphore, blockTime);
+}
+
+void
+semaphoreDelete(Semaphore semaphore)
+{
+    lockDelete(semaphore);
+}
+
+Mutex
+mutexCreate()
+{
+    return lockCreate();
+}
+
+bool
+mutexGive(Mutex mutex)
+{
+    return lockGive(mutex);
+}
+
+bool
+mutexTake(Mutex mutex, const unsigned long blockTime)
+{
+    return lockTake(mutex, blockTime);
+}
+
+void
+mutexDelete(Mutex mutex)
+{
+    lockDelete(mutex);
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void *
+runTask(void * taskPointer)
+{
+    HostTask * self = taskPointer;
+
+    pthread_mutex_lock(&kernel);
+    while (current != self) pthread_cond_wait(&self->turn, &kernel);
+    pthread_mutex_unlock(&kernel);
+
+    self->code(self->parameters);
+
+    pthread_mutex_lock(&kernel);
+    self->state = DEAD;
+    handOff();
+    pthread_mutex_unlock(&kernel);
+    return NULL;
+}
+
+static HostTask *
+createTask(TaskCode code, void * parameters, unsigned int priority)
+{
+    if (taskCount >= MAXTASKS) return NULL;
+    HostTask * task = malloc(sizeof(HostTask));
+    pthread_cond_init(&task->turn, NULL);
+    task->code = code;
+    task->parameters = parameters;
+    task->priority = priority;
+    task->state = SLEEPING;
+    task->readyOrder = 0;
+    task->wakeTime = NEVER;
+    task->blockedOn = NULL;
+    task->taken = false;
+    task->nextWaiter = NULL;
+    tasks[taskCount++] = task;
+    return task;
+}
+
+static void
+makeReady(HostTask * task)
+{
+    task->state = READY;
+    task->wakeTime = NEVER;
+    task->readyOrder = ++readyCount;
+}
+
+// Gives way if something more important has just become ready.
+static void
+preempt(HostTask * self)
+{
+    HostTask * next = nextReady();
+    if (next == NULL || next->priority <= self->priority) return;
+    makeReady(self);
+    schedule(self);
+}
+
+// Passes the baton on, then waits for it to come back. The caller has
+// already taken itself out of the running state.
+static void
+schedule(HostTask * self)
+{
+    handOff();
+    while (current != self) pthread_cond_wait(&self->turn, &kernel);
+}
+
+static void
+handOff()
+{
+    HostTask * next = nextReady();
+    while (next == NULL)
+    {
+        if (!advanceTime())
+        {
+            fflush(stdout);
+            fprintf(stderr, "host: every task is blocked for good\n");
+            exit(1);
+        }
+        next = nextReady();
+    }
+    next->state = RUNNING;
+    current = next;
+    pthread_cond_signal(&next->turn);
+}
+
+// Highest priority first, round robin within a priority.
+static HostTask *
+nextReady()
+{
+    HostTask * next = NULL;
+    for (int i = 0; i < taskCount; i++)
+    {
+        HostTask * task = tasks[i];
+        if (task->state != READY) continue;
+        if (
+            next == NULL ||
+            task->priority > next->priority ||
+            (task->priority == next->priority && task->readyOrder < next->readyOrder)
+        ){
+            next = task;
+        }
+    }
+    return next;
+}
+
+// Nothing can run: jump to the next wake up, and wake everything due then.
+static bool
+advanceTime()
+{
+    unsigned long long wakeTime = NEVER;
+    for (int i = 0; i < taskCount; i++)
+    {
+        HostTaskState state = tasks[i]->state;
+        if (state != SLEEPING && state != BLOCKED) continue;
+        if (tasks[i]->wakeTime < wakeTime) wakeTime = tasks[i]->wakeTime;
+    }
+    if (wakeTime == NEVER) return false;
+
+    if (wakeTime > now)
+    {
+        if (realTime) sleepUntilWall(wallStart + wakeTime);
+        now = wakeTime;
+    }
+
+    for (int i = 0; i < taskCount; i++)
+    {
+        HostTask * task = tasks[i];
+        if (task->state != SLEEPING && task->state != BLOCKED) continue;
+        if (task->wakeTime > now) continue;
+        if (task->state == BLOCKED)
+        {
+            removeWaiter(task->blockedOn, task);
+            task->taken = false;
+        }
+        makeReady(task);
+    }
+    return true;
+}
+
+// A wake time that has already passed still yields to the other ready
+// tasks, as FreeRTOS does.
+static void
+sleepTask(HostTask * self, unsigned long long wakeTime)
+{
+    if (wakeTime <= now)
+    {
+        makeReady(self);
+    }
+    else
+    {
+        self->state = SLEEPING;
+        self->wakeTime = wakeTime;
+    }
+    schedule(self);
+}
+
+static HostLock *
+lockCreate()
+{
+    HostLock * lock = malloc(sizeof(HostLock));
+    lock->isAvailable = true;
+    lock->waiters = NULL;
+    return lock;
+}
+
+static bool
+lockTake(HostLock * lock, unsigned long blockTime)
+{
+    if (lock == NULL) return false;
+    pthread_mutex_lock(&kernel);
+    if (lock->isAvailable)
+    {
+        lock->isAvailable = false;
+        pthread_mutex_unlock(&kernel);
+        return true;
+    }
+    if (blockTime == 0)
+    {
+        pthread_mutex_unlock(&kernel);
+        return false;
+    }
+
+    HostTask * self = current;
+    self->state = BLOCKED;
+    self->wakeTime = blockTime == FOREVER? NEVER : now + blockTime * 1000ULL;
+    self->taken = false;
+    addWaiter(lock, self);
+    schedule(self);
+
+    bool taken = self->taken;
+    pthread_mutex_unlock(&kernel);
+    return taken;
+}
+
+// Hands the lock straight to the first waiter, if there is one.
+static bool
+lockGive(HostLock * lock)
+{
+    if (lock == NULL) return false;
+    pthread_mutex_lock(&kernel);
+    HostTask * waiter = lock->waiters;
+    if (waiter == NULL)
+    {
+        bool given = !lock->isAvailable;
+        lock->isAvailable = true;
+        pthread_mutex_unlock(&kernel);
+        return given;
+    }
+
+    removeWaiter(lock, waiter);
+    waiter->taken = true;
+    makeReady(waiter);
+    preempt(current);
+    pthread_mutex_unlock(&kernel);
+    return true;
+}
+
+static void
+lockDelete(HostLock * lock)
+{
+    if (lock == NULL) return;
+    free(lock);
+}
+
+static void
+addWaiter(HostLock * lock, HostTask * task)
+{
+    task->blockedOn = lock;
+    HostTask ** position = &lock->waiters;
+    while (*position != NULL && (*position)->priority >= task->priority)
+    {
+        position = &(*position)->nextWaiter;
+    }
+    task->nextWaiter = *position;
+    *position = task;
+}
+
+static void
+removeWaiter(HostLock * lock, HostTask * task)
+{
+    HostTask ** position = &lock->waiters;
+    while (*position != NULL && *position != task)
+    {
+        position = &(*position)->nextWaiter;
+    }
+    if (*position != NULL) *position = task->nextWaiter;
+    task->nextWaiter = NULL;
+    task->blockedOn = NULL;
+}
+
+static unsigned long long
+wallMicros()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000ULL + time.tv_nsec / 1000;
+}
+
+static void
+sleepUntilWall(unsigned long long microTime)
+{
+    struct timespec time =
+    {
+        .tv_sec = microTime / 1000000,
+        .tv_nsec = (microTime % 1000000) * 1000
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) == EINTR);
+}
+
+// }}}
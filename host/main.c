@@ -0,0 +1,178 @@
+#include "host.h"
+#include "plant.h"
+#include "main.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+// Where src/init.c expects the flywheel: the motor on port 1 and the
+// encoder on ports 3 and 4, mounted reversed.
+#define PLANTMOTOR 1
+#define PLANTENCODER 3
+#define PLANTREVERSED true
+#define PLANTPERIOD 1
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+PlantTask
+{
+    Plant * plant;
+    unsigned long shotPeriod;
+}
+PlantTask;
+
+// }}}
+
+
+// Private functions, forward declarations {{{
+
+static void runPlant(void * data);
+static void runOperatorControl(void * data);
+static void runAutonomous(void * data);
+static void usage(const char * program);
+
+// }}}
+
+
+
+//
+// Runs the firmware as the Cortex would, minus the competition switch:
+// initializeIO, then initialize, then operatorControl (or autonomous) in
+// its own task. Pigeon reads stdin and writes stdout. The flywheel is
+// simulated by the default plant (see plant.h), launching a ball every
+// --shoot milliseconds if given.
+//
+//     bin/host/robot [--time <seconds>] [--autonomous] [--realtime]
+//         [--shoot <milliseconds>]
+//
+// Runs until the time is up, or forever without --time. Time is virtual, and
+// runs as fast as it can, unless --realtime is given; see host.h.
+//
+int
+main(int argc, char ** argv)
+{
+    unsigned long runTime = 0;
+    bool autonomousMode = false;
+    bool realTime = false;
+    unsigned long shotPeriod = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+        {
+            runTime = strtoul(argv[++i], NULL, 10) * 1000;
+        }
+        else if (strcmp(argv[i], "--autonomous") == 0)
+        {
+            autonomousMode = true;
+        }
+        else if (strcmp(argv[i], "--shoot") == 0 && i + 1 < argc)
+        {
+            shotPeriod = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--realtime") == 0)
+        {
+            realTime = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Telemetry should reach a pipe as it happens.
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    // Lines are only read once they are waiting, which buffering would hide.
+    if (realTime) setvbuf(stdin, NULL, _IONBF, 0);
+
+    hostKernelInit(realTime);
+
+    PlantTask plantTask =
+    {
+        .plant = plantInit(plantSetupDefault()),
+        .shotPeriod = shotPeriod
+    };
+    taskCreate(runPlant, TASK_DEFAULT_STACK_SIZE, &plantTask, TASK_PRIORITY_HIGHEST);
+
+    initializeIO();
+    initialize();
+
+    taskCreate(
+        autonomousMode? runAutonomous : runOperatorControl,
+        TASK_DEFAULT_STACK_SIZE,
+        NULL,
+        TASK_PRIORITY_DEFAULT
+    );
+
+    if (runTime == 0)
+    {
+        while (true) delay(1000);
+    }
+    delay(runTime);
+    fflush(stdout);
+    return 0;
+}
+
+
+
+// Private functions {{{
+
+// Drives the plant from the motor port, and the encoder ports and battery
+// from the plant.
+static void
+runPlant(void * data)
+{
+    PlantTask * task = data;
+    Plant * plant = task->plant;
+    long ticks = 0;
+    unsigned long shotTime = task->shotPeriod;
+    unsigned long wakeTime = millis();
+    while (true)
+    {
+        plantMotorSetter(plant, hostMotorGet(PLANTMOTOR));
+        plantStep(plant, PLANTPERIOD / 1000.0f);
+
+        long newTicks = plantGetTicks(plant);
+        int change = newTicks - ticks;
+        ticks = newTicks;
+        hostEncoderAdd(PLANTENCODER, PLANTREVERSED? -change : change);
+        hostPowerLevelSet(plantGetVoltage(plant) * 1000.0f);
+
+        if (task->shotPeriod > 0 && millis() >= shotTime)
+        {
+            plantShoot(plant);
+            shotTime += task->shotPeriod;
+        }
+
+        taskDelayUntil(&wakeTime, PLANTPERIOD);
+    }
+}
+
+static void
+runOperatorControl(void * data)
+{
+    UNUSED(data);
+    operatorControl();
+}
+
+static void
+runAutonomous(void * data)
+{
+    UNUSED(data);
+    autonomous();
+}
+
+static void
+usage(const char * program)
+{
+    fprintf(stderr, "usage: %s [--time <seconds>] [--autonomous] [--realtime] [--shoot <milliseconds>]\n", program);
+}
+
+// }}}
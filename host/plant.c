@@ -0,0 +1,339 @@
+#include "plant.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "shims.h"
+
+
+// Integration step, seconds.
+#define STEP 0.0005f
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+MotorSpec
+{
+    float voltage;
+    float freeSpeed;
+    float freeCurrent;
+    float stallTorque;
+    float stallCurrent;
+}
+MotorSpec;
+
+struct Plant
+{
+    PlantSetup setup;
+    PlantMotor motor;
+
+    float command;
+    float speed;
+    double angle;
+    double time;
+    float voltage;
+    float current;
+
+    float shotTorque;
+    float shotRemaining;
+
+    long readTicks;
+    double readTime;
+
+    unsigned int random;
+};
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void step(Plant*, float dt);
+static float frictionTorque(Plant*, float driveTorque);
+static float gaussian(Plant*);
+static unsigned int nextRandom(Plant*);
+
+// VEX figures at 7.2V: rpm, A, N m, A.
+static const MotorSpec motorSpecs[] =
+{
+    [MOTOR_TYPE_269] = {7.2f, 100.0f, 0.18f, 0.971f, 2.6f},
+    [MOTOR_TYPE_393_TORQUE] = {7.2f, 100.0f, 0.37f, 1.67f, 4.8f},
+    [MOTOR_TYPE_393_SPEED] = {7.2f, 160.0f, 0.37f, 1.04f, 4.8f}
+};
+
+// }}}
+
+
+
+// Public methods {{{
+
+Plant *
+plantInit(PlantSetup setup)
+{
+    Plant * plant = malloc(sizeof(Plant));
+    plant->setup = setup;
+    plant->motor = plantMotorModel(setup.motorType);
+    plant->command = 0.0f;
+    plant->speed = 0.0f;
+    plant->angle = 0.0;
+    plant->time = 0.0;
+    plant->voltage = setup.batteryVoltage;
+    plant->current = 0.0f;
+    plant->shotTorque = 0.0f;
+    plant->shotRemaining = 0.0f;
+    plant->readTicks = 0;
+    plant->readTime = 0.0;
+    plant->random = setup.seed != 0? setup.seed : 1;
+    return plant;
+}
+
+PlantSetup
+plantSetupDefault()
+{
+    PlantSetup setup =
+    {
+        .motorType = MOTOR_TYPE_393_SPEED,
+        .motorCount = 2,
+        .ratio = 25.0f,
+
+        .inertia = 3.0e-4f,
+
+        .frictionCoulomb = 0.006f,
+        .frictionViscous = 2.0e-5f,
+        .frictionDrag = 3.0e-7f,
+
+        .batteryVoltage = 7.8f,
+        .batteryResistance = 0.15f,
+
+        .ticksPerRev = 360.0f,
+        .encoderNoise = 0.5f,
+
+        .shotLoss = 0.15f,
+        .shotDuration = 0.04f,
+
+        .seed = 1
+    };
+    return setup;
+}
+
+void
+plantDelete(Plant * plant)
+{
+    free(plant);
+}
+
+void
+plantStep(Plant * plant, float dt)
+{
+    while (dt > 0.0f)
+    {
+        float h = dt < STEP? dt : STEP;
+        step(plant, h);
+        dt -= h;
+    }
+}
+
+// The braking torque is fixed at the launch, from the speed then.
+void
+plantShoot(Plant * plant)
+{
+    PlantSetup * setup = &plant->setup;
+    if (setup->shotDuration <= 0.0f) return;
+    plant->shotTorque +=
+        setup->inertia * fabsf(plant->speed) * setup->shotLoss / setup->shotDuration;
+    plant->shotRemaining = setup->shotDuration;
+}
+
+void
+plantSetBattery(Plant * plant, float voltage)
+{
+    plant->setup.batteryVoltage = voltage;
+}
+
+float
+plantGetRpm(Plant * plant)
+{
+    return plant->speed * 60.0f / SHIM_RADIANS_PER_REV;
+}
+
+float
+plantGetTime(Plant * plant)
+{
+    return plant->time;
+}
+
+float
+plantGetVoltage(Plant * plant)
+{
+    return plant->voltage;
+}
+
+float
+plantGetCurrent(Plant * plant)
+{
+    return plant->current;
+}
+
+long
+plantGetTicks(Plant * plant)
+{
+    double ticks = floor(plant->angle * plant->setup.ticksPerRev);
+    if (plant->setup.encoderNoise > 0.0f)
+    {
+        ticks += floor(gaussian(plant) * plant->setup.encoderNoise + 0.5f);
+    }
+    return (long)ticks;
+}
+
+PlantMotor
+plantMotorModel(MotorType type)
+{
+    const MotorSpec * spec = &motorSpecs[type];
+    float freeSpeed = spec->freeSpeed * SHIM_RADIANS_PER_REV / 60.0f;
+    float resistance = spec->voltage / spec->stallCurrent;
+    PlantMotor model =
+    {
+        .torqueConstant = spec->stallTorque / spec->stallCurrent,
+        .speedConstant = (spec->voltage - spec->freeCurrent * resistance) / freeSpeed,
+        .resistance = resistance
+    };
+    return model;
+}
+
+void
+plantMotorSetter(MotorHandle handle, int command)
+{
+    Plant * plant = handle;
+    if (command > 127) command = 127;
+    if (command < -127) command = -127;
+    plant->command = command / 127.0f;
+}
+
+// Reads as a quadrature encoder through encoderGetter would: rpm from the
+// change in count since the last read, over the plant's own time.
+EncoderReading
+plantEncoderGetter(EncoderHandle handle)
+{
+    Plant * plant = handle;
+    long ticks = plantGetTicks(plant);
+    float minutes = (plant->time - plant->readTime) / 60.0f;
+    float ticksPerRev = plant->setup.ticksPerRev;
+
+    float rpm = 0.0f;
+    if (minutes > 0.0f) rpm = (ticks - plant->readTicks) / ticksPerRev / minutes;
+    plant->readTicks = ticks;
+    plant->readTime = plant->time;
+
+    EncoderReading reading =
+    {
+        .revolutions = ticks / ticksPerRev,
+        .rpm = rpm,
+        .microTime = micros()
+    };
+    return reading;
+}
+
+void
+plantEncoderResetter(EncoderHandle handle)
+{
+    Plant * plant = handle;
+    plant->angle = 0.0;
+    plant->readTicks = 0;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+step(Plant * plant, float dt)
+{
+    PlantSetup * setup = &plant->setup;
+    PlantMotor * motor = &plant->motor;
+    float count = setup->motorCount;
+    float u = plant->command;
+    float motorSpeed = plant->speed / setup->ratio;
+    float backEmf = motor->speedConstant * motorSpeed;
+
+    // Solve for the battery's terminal voltage, with every motor drawing
+    // (u V - back emf) / R through its speed controller, u of the time.
+    float sag = setup->batteryResistance * count / motor->resistance;
+    float voltage = (setup->batteryVoltage + sag * u * backEmf) / (1.0f + sag * u * u);
+    float motorCurrent = (u * voltage - backEmf) / motor->resistance;
+    plant->voltage = voltage;
+    plant->current = count * u * motorCurrent;
+
+    float driveTorque = count * motor->torqueConstant * motorCurrent / setup->ratio;
+
+    float shotTorque = 0.0f;
+    if (plant->shotRemaining > 0.0f)
+    {
+        shotTorque = plant->shotTorque;
+        plant->shotRemaining -= dt;
+        if (plant->shotRemaining <= 0.0f) plant->shotTorque = 0.0f;
+    }
+    if (plant->speed < 0.0f) shotTorque = -shotTorque;
+
+    float torque = driveTorque - frictionTorque(plant, driveTorque) - shotTorque;
+    float speed = plant->speed + torque / setup->inertia * dt;
+
+    // Friction stops the wheel, it does not turn it around.
+    if ((plant->speed > 0.0f && speed < 0.0f) || (plant->speed < 0.0f && speed > 0.0f))
+    {
+        speed = 0.0f;
+    }
+
+    plant->angle += speed * dt / SHIM_RADIANS_PER_REV;
+    plant->speed = speed;
+    plant->time += dt;
+}
+
+// At rest, static friction holds against anything up to the Coulomb
+// torque.
+static float
+frictionTorque(Plant * plant, float driveTorque)
+{
+    PlantSetup * setup = &plant->setup;
+    float speed = plant->speed;
+    if (speed == 0.0f)
+    {
+        if (fabsf(driveTorque) <= setup->frictionCoulomb) return driveTorque;
+        return driveTorque > 0.0f? setup->frictionCoulomb : -setup->frictionCoulomb;
+    }
+
+    float magnitude =
+        setup->frictionCoulomb +
+        setup->frictionViscous * fabsf(speed) +
+        setup->frictionDrag * speed * speed;
+    return speed > 0.0f? magnitude : -magnitude;
+}
+
+// Box-Muller, from the plant's own generator so runs repeat.
+static float
+gaussian(Plant * plant)
+{
+    float u1 = (nextRandom(plant) + 1.0f) / 4294967296.0f;
+    float u2 = nextRandom(plant) / 4294967296.0f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(SHIM_RADIANS_PER_REV * u2);
+}
+
+// xorshift32
+static unsigned int
+nextRandom(Plant * plant)
+{
+    unsigned int x = plant->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    plant->random = x;
+    return x;
+}
+
+// }}}
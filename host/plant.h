@@ -0,0 +1,142 @@
+#ifndef PLANT_H_
+#define PLANT_H_
+
+#include <stdbool.h>
+#include "shims.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Typedefs {{{
+
+struct Plant;
+typedef struct Plant Plant;
+
+typedef struct
+PlantSetup
+{
+    // Drive: identical motors ganged on the wheel, each geared so that
+    // the wheel turns ratio times as fast as the motor.
+    MotorType motorType;
+    unsigned int motorCount;
+    float ratio;
+
+    // Wheel, kg m^2
+    float inertia;
+
+    // Friction torques at the wheel, N m: constant (and static), per rad/s
+    // and per (rad/s)^2.
+    float frictionCoulomb;
+    float frictionViscous;
+    float frictionDrag;
+
+    // Battery: open circuit volts, and internal plus wiring resistance,
+    // ohms, which makes the voltage sag under load.
+    float batteryVoltage;
+    float batteryResistance;
+
+    // Encoder on the wheel: counts per revolution, and the standard
+    // deviation of the count's noise, in counts.
+    float ticksPerRev;
+    float encoderNoise;
+
+    // Ball launches take this fraction of the wheel's speed, over the
+    // contact time in seconds.
+    float shotLoss;
+    float shotDuration;
+
+    unsigned int seed;
+}
+PlantSetup;
+
+// Motor constants, at the motor's own shaft: N m/A, V s/rad and ohms.
+typedef struct
+PlantMotor
+{
+    float torqueConstant;
+    float speedConstant;
+    float resistance;
+}
+PlantMotor;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Flywheel plant for the host: DC motors driven through a speed
+// controller from a battery with internal resistance, spinning an inertia
+// against friction. Time only passes in plantStep, so the plant is as
+// deterministic as whatever steps it.
+//
+// The motor and encoder shim interfaces let any controller be closed
+// around it unchanged: pass the plant as both the MotorHandle and the
+// EncoderHandle.
+//
+Plant *
+plantInit(PlantSetup);
+
+//
+// Roughly the robot's flywheel: two 393 motors in speed configuration
+// geared 1:25 onto a light wheel, on a charged battery.
+//
+PlantSetup
+plantSetupDefault();
+
+void
+plantDelete(Plant*);
+
+void
+plantStep(Plant*, float dt);
+
+void
+plantShoot(Plant*);
+
+void
+plantSetBattery(Plant*, float voltage);
+
+float
+plantGetRpm(Plant*);
+
+float
+plantGetTime(Plant*);
+
+// Battery terminal volts and current drawn, amps.
+float
+plantGetVoltage(Plant*);
+
+float
+plantGetCurrent(Plant*);
+
+// Raw encoder count, with quantisation and noise.
+long
+plantGetTicks(Plant*);
+
+PlantMotor
+plantMotorModel(MotorType);
+
+void
+plantMotorSetter(MotorHandle, int command);
+
+EncoderReading
+plantEncoderGetter(EncoderHandle);
+
+void
+plantEncoderResetter(EncoderHandle);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
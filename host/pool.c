@@ -0,0 +1,170 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+struct Pool;
+typedef struct Pool Pool;
+
+// The indices [next, end) are left to do. The owner takes from next, and
+// thieves from end.
+typedef struct
+PoolWorker
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    unsigned long next;
+    unsigned long end;
+    unsigned int id;
+    Pool * pool;
+}
+PoolWorker;
+
+struct Pool
+{
+    PoolJob job;
+    void * context;
+    unsigned int threads;
+    PoolWorker * workers;
+};
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void * work(void * worker);
+static bool take(PoolWorker*, unsigned long * index);
+static bool steal(PoolWorker * thief);
+
+// }}}
+
+
+
+// Public methods {{{
+
+void
+poolRun(unsigned int threads, unsigned long count, PoolJob job, void * context)
+{
+    if (threads == 0) threads = poolDefaultThreads();
+    if (threads > count) threads = count > 0? count : 1;
+
+    Pool pool =
+    {
+        .job = job,
+        .context = context,
+        .threads = threads,
+        .workers = malloc(threads * sizeof(PoolWorker))
+    };
+
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        PoolWorker * worker = &pool.workers[i];
+        pthread_mutex_init(&worker->mutex, NULL);
+        worker->next = count * i / threads;
+        worker->end = count * (i + 1) / threads;
+        worker->id = i;
+        worker->pool = &pool;
+    }
+
+    // The calling thread works as worker 0.
+    for (unsigned int i = 1; i < threads; i++)
+    {
+        pthread_create(&pool.workers[i].thread, NULL, work, &pool.workers[i]);
+    }
+    work(&pool.workers[0]);
+    for (unsigned int i = 1; i < threads; i++)
+    {
+        pthread_join(pool.workers[i].thread, NULL);
+    }
+
+    for (unsigned int i = 0; i < threads; i++)
+    {
+        pthread_mutex_destroy(&pool.workers[i].mutex);
+    }
+    free(pool.workers);
+}
+
+unsigned int
+poolDefaultThreads()
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0? cores : 1;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+// No job makes more jobs, so once every share is empty there is nothing
+// left to steal, and the worker is done.
+static void *
+work(void * workerPointer)
+{
+    PoolWorker * worker = workerPointer;
+    Pool * pool = worker->pool;
+    while (true)
+    {
+        unsigned long index;
+        if (take(worker, &index))
+        {
+            pool->job(pool->context, index);
+            continue;
+        }
+        if (!steal(worker)) break;
+    }
+    return NULL;
+}
+
+static bool
+take(PoolWorker * worker, unsigned long * index)
+{
+    pthread_mutex_lock(&worker->mutex);
+    bool taken = worker->next < worker->end;
+    if (taken) *index = worker->next++;
+    pthread_mutex_unlock(&worker->mutex);
+    return taken;
+}
+
+// Takes the back half of the first non-empty share after the thief's own.
+static bool
+steal(PoolWorker * thief)
+{
+    Pool * pool = thief->pool;
+    for (unsigned int i = 1; i < pool->threads; i++)
+    {
+        PoolWorker * victim = &pool->workers[(thief->id + i) % pool->threads];
+
+        pthread_mutex_lock(&victim->mutex);
+        unsigned long left = victim->end - victim->next;
+        if (left == 0)
+        {
+            pthread_mutex_unlock(&victim->mutex);
+            continue;
+        }
+        unsigned long middle = victim->end - (left + 1) / 2;
+        unsigned long end = victim->end;
+        victim->end = middle;
+        pthread_mutex_unlock(&victim->mutex);
+
+        pthread_mutex_lock(&thief->mutex);
+        thief->next = middle;
+        thief->end = end;
+        pthread_mutex_unlock(&thief->mutex);
+        return true;
+    }
+    return false;
+}
+
+// }}}
@@ -0,0 +1,46 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Typedefs {{{
+
+typedef void
+(*PoolJob)(void * context, unsigned long index);
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Runs job(context, i) for every i below count on a pool of threads, and
+// returns once all are done. Each thread starts with an even share of the
+// indices and works through it from the front; a thread that runs out
+// steals the back half of another's remaining share. Jobs may run in any
+// order, and on any thread.
+//
+// Zero threads means one per online core.
+//
+void
+poolRun(unsigned int threads, unsigned long count, PoolJob, void * context);
+
+unsigned int
+poolDefaultThreads();
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,255 @@
+#include "batch.h"
+#include "episode.h"
+#include "control.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+
+#define NUMOFGAINS BATCH_NUMOFGAINS
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+Law
+{
+    char * name;
+    BatchLaw law;
+    ControlHandle (*init)(const float gains[]);
+    ControlUpdater updater;
+    ControlResetter resetter;
+    float gains[NUMOFGAINS];
+}
+Law;
+
+typedef struct
+Check
+{
+    unsigned long mismatches;
+    float settle;
+    float overshoot;
+    float iae;
+}
+Check;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static ControlHandle pidCreate(const float gains[]);
+static ControlHandle tbhCreate(const float gains[]);
+static ControlHandle bangBangCreate(const float gains[]);
+static void laneSetup(const Law*, unsigned int lane, PlantSetup*, float gains[]);
+static void compare(Check*, const EpisodeResult * batch, const EpisodeResult * scalar);
+static float difference(float a, float b);
+static double wallNow();
+
+// The gains bench runs, which each lane scales.
+static const Law laws[] =
+{
+    {"pid", BATCH_LAW_PID, pidCreate, pidUpdate, pidReset, {0.1f, 0.08f, 0.004f}},
+    {"tbh", BATCH_LAW_TBH, tbhCreate, tbhUpdate, tbhReset, {0.2f, 10.0f}},
+    {"bang-bang", BATCH_LAW_BANGBANG, bangBangCreate, bangBangUpdate, bangBangReset, {127.0f, 40.0f}}
+};
+
+#define NUMOFLAWS (int)(sizeof(laws) / sizeof(Law))
+
+// }}}
+
+
+
+//
+// Runs the same lanes through each law and scenario twice, once on the
+// batch simulator and once episode by episode with the controllers of
+// src/control.c, checks that the two agree, and reports how many seconds
+// of flywheel each simulates per second of wall time, on one thread.
+//
+//     bin/host/batch [--lanes <count>]
+//
+// Lanes differ in gains, battery, inertia and encoder noise. Exits 1 if
+// any lane's results differ by more than rounding; see compare.
+//
+int
+main(int argc, char ** argv)
+{
+    unsigned int count = 256;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--lanes") == 0 && i + 1 < argc)
+        {
+            count = strtoul(argv[++i], NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--lanes <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0) count = 1;
+
+    EpisodeResult * batchResults = malloc(count * sizeof(EpisodeResult));
+    EpisodeResult * scalarResults = malloc(count * sizeof(EpisodeResult));
+    PlantSetup * setups = malloc(count * sizeof(PlantSetup));
+    float * gains = malloc(count * NUMOFGAINS * sizeof(float));
+    bool passed = true;
+
+    printf(
+        "%-10s %-10s %9s %9s %9s %9s %12s %12s %8s\n",
+        "law", "scenario", "mismatch", "settle/s", "over/rpm", "iae/rpm.s",
+        "scalar s/s", "batch s/s", "speedup"
+    );
+    for (int i = 0; i < NUMOFLAWS; i++)
+    {
+        const Law * law = &laws[i];
+        Batch * batch = batchInit(law->law, count);
+        for (unsigned int j = 0; j < count; j++)
+        {
+            laneSetup(law, j, &setups[j], &gains[j * NUMOFGAINS]);
+            batchSetLane(batch, j, setups[j], &gains[j * NUMOFGAINS]);
+        }
+
+        for (int j = 0; j < EPISODE_NUMOFSCENARIOS; j++)
+        {
+            const EpisodeScenario * scenario = &EPISODE_SCENARIOS[j];
+            double simulated = count * (double)(scenario->warmTime + scenario->time);
+
+            double start = wallNow();
+            batchRun(batch, scenario, batchResults);
+            double batchTime = wallNow() - start;
+
+            start = wallNow();
+            for (unsigned int k = 0; k < count; k++)
+            {
+                ControlHandle control = law->init(&gains[k * NUMOFGAINS]);
+                scalarResults[k] = episodeRun(
+                    control,
+                    law->updater,
+                    law->resetter,
+                    scenario,
+                    setups[k]
+                );
+                free(control);
+            }
+            double scalarTime = wallNow() - start;
+
+            Check check = {0};
+            for (unsigned int k = 0; k < count; k++)
+            {
+                compare(&check, &batchResults[k], &scalarResults[k]);
+            }
+            if (check.mismatches > 0) passed = false;
+
+            printf(
+                "%-10s %-10s %9lu %9.2g %9.2g %9.2g %12.0f %12.0f %7.1fx\n",
+                law->name,
+                scenario->name,
+                check.mismatches,
+                check.settle,
+                check.overshoot,
+                check.iae,
+                simulated / scalarTime,
+                simulated / batchTime,
+                scalarTime / batchTime
+            );
+        }
+        batchDelete(batch);
+    }
+    printf(
+        "%u lanes, s/s is simulated seconds per wall second on one thread; batch %s the scalar runs\n",
+        count,
+        passed? "matches" : "DOES NOT MATCH"
+    );
+
+    free(gains);
+    free(setups);
+    free(scalarResults);
+    free(batchResults);
+    return passed? 0 : 1;
+}
+
+
+
+// Private functions {{{
+
+static ControlHandle
+pidCreate(const float gains[])
+{
+    return pidInit(gains[0], gains[1], gains[2]);
+}
+
+static ControlHandle
+tbhCreate(const float gains[])
+{
+    return tbhInit(gains[0], gains[1], episodeEstimator);
+}
+
+static ControlHandle
+bangBangCreate(const float gains[])
+{
+    return bangBangInit(gains[0], gains[1], gains[2], gains[3]);
+}
+
+// Gains from half to one and a half times the law's, and plants spread
+// about the default, both evenly over the lanes, in different orders.
+static void
+laneSetup(const Law * law, unsigned int lane, PlantSetup * setup, float gains[])
+{
+    float spread = (lane * 7919 % 1024) / 1024.0f;
+    for (int i = 0; i < NUMOFGAINS; i++) gains[i] = law->gains[i] * (0.5f + spread);
+
+    float plantSpread = (lane * 104729 % 1024) / 1024.0f;
+    *setup = plantSetupDefault();
+    setup->batteryVoltage = 7.0f + 1.4f * plantSpread;
+    setup->inertia *= 0.85f + 0.3f * spread;
+    setup->encoderNoise *= 0.5f + 1.5f * plantSpread;
+    setup->seed = lane + 1;
+}
+
+// Both sides do the same arithmetic in the same order, and agree exactly
+// unless the compiler contracts or reorders one of them; a lane only fails
+// if it is out by more than a frame, or by more than a hundredth.
+static void
+compare(Check * check, const EpisodeResult * batch, const EpisodeResult * scalar)
+{
+    float settle = difference(batch->settle, scalar->settle);
+    float rise = difference(batch->rise, scalar->rise);
+    float overshoot = difference(batch->overshoot, scalar->overshoot);
+    float iae = difference(batch->iae, scalar->iae);
+
+    if (settle > check->settle) check->settle = settle;
+    if (overshoot > check->overshoot) check->overshoot = overshoot;
+    if (iae > check->iae) check->iae = iae;
+
+    bool matches =
+        (batch->settle < 0.0f) == (scalar->settle < 0.0f) &&
+        (batch->rise < 0.0f) == (scalar->rise < 0.0f) &&
+        settle <= EPISODE_FRAME * 1.5f &&
+        rise <= EPISODE_FRAME * 1.5f &&
+        overshoot <= 0.01f * fmaxf(1.0f, fabsf(scalar->overshoot)) &&
+        iae <= 0.01f * fmaxf(1.0f, fabsf(scalar->iae));
+    if (!matches) check->mismatches++;
+}
+
+static float
+difference(float a, float b)
+{
+    return fabsf(a - b);
+}
+
+static double
+wallNow()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// }}}
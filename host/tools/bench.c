@@ -0,0 +1,183 @@
+#include "episode.h"
+#include "control.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+#define NUMOFSCENARIOS EPISODE_NUMOFSCENARIOS
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+Controller
+{
+    char * name;
+    ControlHandle (*init)();
+    ControlUpdater updater;
+    ControlResetter resetter;
+}
+Controller;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static ControlHandle pidCreate();
+static ControlHandle tbhCreate();
+static ControlHandle bangBangCreate();
+static ControlHandle feedforwardCreate();
+static void printTable(EpisodeResult results[], int controllerCount);
+static void printJson(EpisodeResult results[], int controllerCount);
+static void printJsonTime(float time);
+
+static Controller controllers[] =
+{
+    {"pid", pidCreate, pidUpdate, pidReset},
+    {"tbh", tbhCreate, tbhUpdate, tbhReset},
+    {"bang-bang", bangBangCreate, bangBangUpdate, bangBangReset},
+    {"ff-tbh", feedforwardCreate, feedforwardUpdate, feedforwardReset}
+};
+
+#define NUMOFCONTROLLERS (int)(sizeof(controllers) / sizeof(Controller))
+
+// }}}
+
+
+
+//
+// Scores each controller in src/control.c on the same scenarios (see
+// episode.h), closed around the default plant, and prints a table, or JSON
+// with --json.
+//
+//     bin/host/bench [--json]
+//
+int
+main(int argc, char ** argv)
+{
+    bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+
+    EpisodeResult results[NUMOFCONTROLLERS * NUMOFSCENARIOS];
+    for (int i = 0; i < NUMOFCONTROLLERS; i++)
+    {
+        Controller * controller = &controllers[i];
+        for (int j = 0; j < NUMOFSCENARIOS; j++)
+        {
+            results[i * NUMOFSCENARIOS + j] = episodeRun(
+                controller->init(),
+                controller->updater,
+                controller->resetter,
+                &EPISODE_SCENARIOS[j],
+                plantSetupDefault()
+            );
+        }
+    }
+
+    if (json) printJson(results, NUMOFCONTROLLERS);
+    else printTable(results, NUMOFCONTROLLERS);
+    return 0;
+}
+
+
+
+// Private functions {{{
+
+static ControlHandle
+pidCreate()
+{
+    return pidInit(0.1f, 0.08f, 0.004f);
+}
+
+static ControlHandle
+tbhCreate()
+{
+    return tbhInit(0.2f, 10.0f, episodeEstimator);
+}
+
+static ControlHandle
+bangBangCreate()
+{
+    return bangBangInit(127.0f, 40.0f, 0.0f, 0.0f);
+}
+
+static ControlHandle
+feedforwardCreate()
+{
+    return feedforwardInit(
+        episodeEstimator,
+        NULL,
+        tbhUpdate,
+        tbhReset,
+        tbhInit(0.2f, 10.0f, episodeEstimator)
+    );
+}
+
+static void
+printTable(EpisodeResult results[], int controllerCount)
+{
+    printf(
+        "%-10s %-10s %8s %10s %8s %12s %10s\n",
+        "controller", "scenario", "rise/s", "over/rpm", "settle/s", "iae/rpm.s",
+        EPISODE_CPUUNIT
+    );
+    for (int i = 0; i < controllerCount; i++)
+    {
+        for (int j = 0; j < NUMOFSCENARIOS; j++)
+        {
+            EpisodeResult * result = &results[i * NUMOFSCENARIOS + j];
+            char rise[16] = "-";
+            char settle[16] = "-";
+            if (result->rise >= 0.0f) sprintf(rise, "%.2f", result->rise);
+            if (result->settle >= 0.0f) sprintf(settle, "%.2f", result->settle);
+            printf(
+                "%-10s %-10s %8s %10.1f %8s %12.1f %10.1f\n",
+                controllers[i].name,
+                EPISODE_SCENARIOS[j].name,
+                rise,
+                result->overshoot,
+                settle,
+                result->iae,
+                result->cpu
+            );
+        }
+    }
+}
+
+static void
+printJson(EpisodeResult results[], int controllerCount)
+{
+    printf("{\"frame\": %g, \"cpuUnit\": \"%s\", \"results\": [", EPISODE_FRAME, EPISODE_CPUUNIT);
+    for (int i = 0; i < controllerCount; i++)
+    {
+        for (int j = 0; j < NUMOFSCENARIOS; j++)
+        {
+            EpisodeResult * result = &results[i * NUMOFSCENARIOS + j];
+            if (i > 0 || j > 0) printf(",");
+            printf(
+                "\n  {\"controller\": \"%s\", \"scenario\": \"%s\", \"rise\": ",
+                controllers[i].name,
+                EPISODE_SCENARIOS[j].name
+            );
+            printJsonTime(result->rise);
+            printf(", \"overshoot\": %.3f, \"settle\": ", result->overshoot);
+            printJsonTime(result->settle);
+            printf(", \"iae\": %.3f, \"cpu\": %.1f}", result->iae, result->cpu);
+        }
+    }
+    printf("\n]}\n");
+}
+
+static void
+printJsonTime(float time)
+{
+    if (time < 0.0f) printf("null");
+    else printf("%.3f", time);
+}
+
+// }}}
@@ -0,0 +1,556 @@
+#include "episode.h"
+#include "pool.h"
+#include "control.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+
+#define NUMOFPARAMETERS 3
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+Parameter
+{
+    char * name;
+    float value;
+}
+Parameter;
+
+typedef struct
+Controller
+{
+    char * name;
+    ControlHandle (*init)(const float * values, ControlHandle * inner);
+    ControlUpdater updater;
+    ControlResetter resetter;
+    Parameter parameters[NUMOFPARAMETERS];
+}
+Controller;
+
+// A range to search for one parameter: steps values from min to max
+// inclusive on a grid, or anywhere between them at random.
+typedef struct
+Range
+{
+    float min;
+    float max;
+    unsigned int steps;
+}
+Range;
+
+typedef struct
+Score
+{
+    float settled;
+    float settle;
+    float worstSettle;
+    float overshoot;
+    float iae;
+    unsigned long candidate;
+}
+Score;
+
+typedef struct
+Sweep
+{
+    const Controller * controller;
+    float * candidates;
+    unsigned long candidateCount;
+    PlantSetup * variations;
+    unsigned int variationCount;
+    const EpisodeScenario ** scenarios;
+    unsigned int scenarioCount;
+    EpisodeResult * results;
+}
+Sweep;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static ControlHandle pidCreate(const float * values, ControlHandle * inner);
+static ControlHandle tbhCreate(const float * values, ControlHandle * inner);
+static ControlHandle feedforwardCreate(const float * values, ControlHandle * inner);
+static void runEpisode(void * sweep, unsigned long index);
+static const Controller * findController(const char * name);
+static int findParameter(const Controller*, const char * name, size_t length);
+static bool parseRange(const Controller*, const char * spec, Range ranges[]);
+static float * gridCandidates(const Controller*, Range ranges[], unsigned long * count);
+static float * randomCandidates(
+    const Controller*,
+    Range ranges[],
+    unsigned long count,
+    unsigned int seed
+);
+static PlantSetup variationSetup(unsigned int seed, unsigned int variation);
+static void scoreCandidates(Sweep*, Score scores[]);
+static int compareScores(const void * a, const void * b);
+static void printScores(Sweep*, Score scores[], unsigned long top);
+static float uniform(unsigned int * state, float min, float max);
+static unsigned int nextRandom(unsigned int * state);
+static double wallNow();
+static void usage(const char * program);
+
+// Parameters not searched keep these values, which bench uses.
+static const Controller controllers[] =
+{
+    {
+        "pid", pidCreate, pidUpdate, pidReset,
+        {{"p", 0.1f}, {"i", 0.08f}, {"d", 0.004f}}
+    },
+    {
+        "tbh", tbhCreate, tbhUpdate, tbhReset,
+        {{"gain", 0.2f}, {"slew", 10.0f}}
+    },
+    {
+        "ff-tbh", feedforwardCreate, feedforwardUpdate, feedforwardReset,
+        {{"gain", 0.2f}, {"slew", 10.0f}}
+    }
+};
+
+#define NUMOFCONTROLLERS (int)(sizeof(controllers) / sizeof(Controller))
+
+// }}}
+
+
+
+//
+// Searches a controller's gains on the simulated flywheel: runs every
+// candidate on every scenario (see episode.h), on the default plant and on
+// Monte-Carlo variations of it, and ranks the candidates by mean settle
+// time, then mean overshoot.
+//
+//     bin/host/sweep <pid|tbh|ff-tbh> [--random <count>]
+//         <parameter>=<min>:<max>[:<steps>] ...
+//         [--monte-carlo <variations>] [--scenario <name>] ...
+//         [--threads <count>] [--top <count>] [--seed <seed>]
+//
+// On the grid (the default), each parameter takes steps values, 5 if not
+// given. With --random, count candidates are drawn uniformly from the
+// ranges instead. Each variation varies the battery, inertia, friction and
+// encoder noise, and every candidate meets the same variations. Episodes
+// run on --threads threads, one per core if not given.
+//
+int
+main(int argc, char ** argv)
+{
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    const Controller * controller = findController(argv[1]);
+    if (controller == NULL)
+    {
+        fprintf(stderr, "unknown controller: %s\n", argv[1]);
+        return 1;
+    }
+
+    Range ranges[NUMOFPARAMETERS];
+    for (int i = 0; i < NUMOFPARAMETERS; i++)
+    {
+        Range fixed = {controller->parameters[i].value, controller->parameters[i].value, 1};
+        ranges[i] = fixed;
+    }
+
+    unsigned long randomCount = 0;
+    unsigned int variationCount = 1;
+    unsigned int threads = 0;
+    unsigned long top = 10;
+    unsigned int seed = 1;
+    const EpisodeScenario * scenarios[EPISODE_NUMOFSCENARIOS];
+    unsigned int scenarioCount = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--random") == 0 && hasValue)
+        {
+            randomCount = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--monte-carlo") == 0 && hasValue)
+        {
+            variationCount = strtoul(argv[++i], NULL, 10) + 1;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            threads = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--top") == 0 && hasValue)
+        {
+            top = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--scenario") == 0 && hasValue)
+        {
+            const EpisodeScenario * scenario = episodeFindScenario(argv[++i]);
+            if (scenario == NULL || scenarioCount == EPISODE_NUMOFSCENARIOS)
+            {
+                fprintf(stderr, "unknown scenario: %s\n", argv[i]);
+                return 1;
+            }
+            scenarios[scenarioCount++] = scenario;
+        }
+        else if (!parseRange(controller, argv[i], ranges))
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (scenarioCount == 0)
+    {
+        for (int i = 0; i < EPISODE_NUMOFSCENARIOS; i++) scenarios[i] = &EPISODE_SCENARIOS[i];
+        scenarioCount = EPISODE_NUMOFSCENARIOS;
+    }
+    if (threads == 0) threads = poolDefaultThreads();
+
+    Sweep sweep =
+    {
+        .controller = controller,
+        .variationCount = variationCount,
+        .scenarios = scenarios,
+        .scenarioCount = scenarioCount
+    };
+    if (randomCount > 0)
+    {
+        sweep.candidateCount = randomCount;
+        sweep.candidates = randomCandidates(controller, ranges, randomCount, seed);
+    }
+    else
+    {
+        sweep.candidates = gridCandidates(controller, ranges, &sweep.candidateCount);
+    }
+
+    sweep.variations = malloc(variationCount * sizeof(PlantSetup));
+    for (unsigned int i = 0; i < variationCount; i++)
+    {
+        sweep.variations[i] = variationSetup(seed, i);
+    }
+
+    unsigned long episodes = sweep.candidateCount * variationCount * scenarioCount;
+    sweep.results = malloc(episodes * sizeof(EpisodeResult));
+
+    double start = wallNow();
+    poolRun(threads, episodes, runEpisode, &sweep);
+    double elapsed = wallNow() - start;
+
+    Score * scores = malloc(sweep.candidateCount * sizeof(Score));
+    scoreCandidates(&sweep, scores);
+    qsort(scores, sweep.candidateCount, sizeof(Score), compareScores);
+    printScores(&sweep, scores, top);
+
+    fprintf(
+        stderr,
+        "%lu candidates, %u variations, %u scenarios: %lu episodes in %.2fs on %u threads, %.0f episodes/s\n",
+        sweep.candidateCount,
+        variationCount,
+        scenarioCount,
+        episodes,
+        elapsed,
+        threads,
+        episodes / elapsed
+    );
+
+    free(scores);
+    free(sweep.results);
+    free(sweep.variations);
+    free(sweep.candidates);
+    return 0;
+}
+
+
+
+// Private functions {{{
+
+// The controllers in src/control.c are single allocations, so each is
+// freed as a whole, along with the one it wraps, if any.
+static ControlHandle
+pidCreate(const float * values, ControlHandle * inner)
+{
+    *inner = NULL;
+    return pidInit(values[0], values[1], values[2]);
+}
+
+static ControlHandle
+tbhCreate(const float * values, ControlHandle * inner)
+{
+    *inner = NULL;
+    return tbhInit(values[0], values[1], episodeEstimator);
+}
+
+static ControlHandle
+feedforwardCreate(const float * values, ControlHandle * inner)
+{
+    *inner = tbhInit(values[0], values[1], episodeEstimator);
+    return feedforwardInit(episodeEstimator, NULL, tbhUpdate, tbhReset, *inner);
+}
+
+// Episodes are numbered candidate major, then variation, then scenario.
+static void
+runEpisode(void * sweepPointer, unsigned long index)
+{
+    Sweep * sweep = sweepPointer;
+    const Controller * controller = sweep->controller;
+    unsigned long scenario = index % sweep->scenarioCount;
+    unsigned long variation = index / sweep->scenarioCount % sweep->variationCount;
+    unsigned long candidate = index / sweep->scenarioCount / sweep->variationCount;
+
+    ControlHandle inner;
+    ControlHandle control = controller->init(
+        &sweep->candidates[candidate * NUMOFPARAMETERS],
+        &inner
+    );
+    sweep->results[index] = episodeRun(
+        control,
+        controller->updater,
+        controller->resetter,
+        sweep->scenarios[scenario],
+        sweep->variations[variation]
+    );
+    free(control);
+    free(inner);
+}
+
+static const Controller *
+findController(const char * name)
+{
+    for (int i = 0; i < NUMOFCONTROLLERS; i++)
+    {
+        if (strcmp(controllers[i].name, name) == 0) return &controllers[i];
+    }
+    return NULL;
+}
+
+static int
+findParameter(const Controller * controller, const char * name, size_t length)
+{
+    for (int i = 0; i < NUMOFPARAMETERS; i++)
+    {
+        const char * parameter = controller->parameters[i].name;
+        if (parameter != NULL && strlen(parameter) == length && strncmp(parameter, name, length) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// name=min:max[:steps]
+static bool
+parseRange(const Controller * controller, const char * spec, Range ranges[])
+{
+    const char * equals = strchr(spec, '=');
+    if (equals == NULL) return false;
+    int parameter = findParameter(controller, spec, equals - spec);
+    if (parameter < 0) return false;
+
+    char * end;
+    Range range = {.steps = 5};
+    range.min = strtof(equals + 1, &end);
+    if (*end != ':') return false;
+    range.max = strtof(end + 1, &end);
+    if (*end == ':') range.steps = strtoul(end + 1, &end, 10);
+    if (*end != '\0' || range.steps == 0) return false;
+
+    ranges[parameter] = range;
+    return true;
+}
+
+static float *
+gridCandidates(const Controller * controller, Range ranges[], unsigned long * count)
+{
+    UNUSED(controller);
+    *count = 1;
+    for (int i = 0; i < NUMOFPARAMETERS; i++) *count *= ranges[i].steps;
+
+    float * candidates = malloc(*count * NUMOFPARAMETERS * sizeof(float));
+    for (unsigned long i = 0; i < *count; i++)
+    {
+        // The last parameter varies fastest.
+        unsigned long rest = i;
+        for (int j = NUMOFPARAMETERS - 1; j >= 0; j--)
+        {
+            Range * range = &ranges[j];
+            unsigned long step = rest % range->steps;
+            rest /= range->steps;
+            float value = range->min;
+            if (range->steps > 1)
+            {
+                value += (range->max - range->min) * step / (range->steps - 1);
+            }
+            candidates[i * NUMOFPARAMETERS + j] = value;
+        }
+    }
+    return candidates;
+}
+
+static float *
+randomCandidates(
+    const Controller * controller,
+    Range ranges[],
+    unsigned long count,
+    unsigned int seed
+){
+    UNUSED(controller);
+    unsigned int state = seed * 2654435761u;
+    if (state == 0) state = 1;
+
+    float * candidates = malloc(count * NUMOFPARAMETERS * sizeof(float));
+    for (unsigned long i = 0; i < count; i++)
+    {
+        for (int j = 0; j < NUMOFPARAMETERS; j++)
+        {
+            candidates[i * NUMOFPARAMETERS + j] = uniform(&state, ranges[j].min, ranges[j].max);
+        }
+    }
+    return candidates;
+}
+
+// Variation 0 is the default plant. The rest depend only on the seed and
+// their number, so every candidate meets the same ones, and a sweep
+// repeats.
+static PlantSetup
+variationSetup(unsigned int seed, unsigned int variation)
+{
+    PlantSetup setup = plantSetupDefault();
+    if (variation == 0) return setup;
+
+    unsigned int state = (seed * 2654435761u) ^ (variation * 2246822519u);
+    if (state == 0) state = 1;
+    // Let the mixing settle.
+    for (int i = 0; i < 4; i++) nextRandom(&state);
+
+    setup.batteryVoltage = uniform(&state, 7.0f, 8.4f);
+    setup.inertia *= uniform(&state, 0.85f, 1.15f);
+    float friction = uniform(&state, 0.8f, 1.2f);
+    setup.frictionCoulomb *= friction;
+    setup.frictionViscous *= friction;
+    setup.frictionDrag *= friction;
+    setup.encoderNoise *= uniform(&state, 0.5f, 2.0f);
+    setup.seed = nextRandom(&state);
+    return setup;
+}
+
+// Runs that never settle count as settling at twice their length.
+static void
+scoreCandidates(Sweep * sweep, Score scores[])
+{
+    unsigned long runs = sweep->variationCount * sweep->scenarioCount;
+    for (unsigned long i = 0; i < sweep->candidateCount; i++)
+    {
+        Score score = {.candidate = i};
+        for (unsigned long j = 0; j < runs; j++)
+        {
+            EpisodeResult * result = &sweep->results[i * runs + j];
+            float settle = result->settle;
+            if (settle >= 0.0f) score.settled += 1.0f;
+            else settle = 2.0f * sweep->scenarios[j % sweep->scenarioCount]->time;
+
+            score.settle += settle;
+            if (settle > score.worstSettle) score.worstSettle = settle;
+            score.overshoot += result->overshoot;
+            score.iae += result->iae;
+        }
+        score.settled /= runs;
+        score.settle /= runs;
+        score.overshoot /= runs;
+        score.iae /= runs;
+        scores[i] = score;
+    }
+}
+
+static int
+compareScores(const void * a, const void * b)
+{
+    const Score * x = a;
+    const Score * y = b;
+    if (x->settle != y->settle) return x->settle < y->settle? -1 : 1;
+    if (x->overshoot != y->overshoot) return x->overshoot < y->overshoot? -1 : 1;
+    return x->candidate < y->candidate? -1 : x->candidate > y->candidate;
+}
+
+static void
+printScores(Sweep * sweep, Score scores[], unsigned long top)
+{
+    const Controller * controller = sweep->controller;
+    if (top > sweep->candidateCount) top = sweep->candidateCount;
+
+    printf("%-5s", "rank");
+    for (int i = 0; i < NUMOFPARAMETERS; i++)
+    {
+        if (controller->parameters[i].name != NULL) printf(" %10s", controller->parameters[i].name);
+    }
+    printf(" %8s %8s %8s %10s %12s\n", "settled", "settle/s", "worst/s", "over/rpm", "iae/rpm.s");
+
+    for (unsigned long i = 0; i < top; i++)
+    {
+        Score * score = &scores[i];
+        float * values = &sweep->candidates[score->candidate * NUMOFPARAMETERS];
+        printf("%-5lu", i + 1);
+        for (int j = 0; j < NUMOFPARAMETERS; j++)
+        {
+            if (controller->parameters[j].name != NULL) printf(" %10.5g", values[j]);
+        }
+        printf(
+            " %7.0f%% %8.2f %8.2f %10.1f %12.1f\n",
+            score->settled * 100.0f,
+            score->settle,
+            score->worstSettle,
+            score->overshoot,
+            score->iae
+        );
+    }
+}
+
+static float
+uniform(unsigned int * state, float min, float max)
+{
+    return min + (max - min) * (nextRandom(state) / 4294967296.0f);
+}
+
+// xorshift32
+static unsigned int
+nextRandom(unsigned int * state)
+{
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double
+wallNow()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void
+usage(const char * program)
+{
+    fprintf(
+        stderr,
+        "usage: %s <pid|tbh|ff-tbh> [--random <count>] <parameter>=<min>:<max>[:<steps>] ...\n"
+        "    [--monte-carlo <variations>] [--scenario <name>] ... [--threads <count>]\n"
+        "    [--top <count>] [--seed <seed>]\n",
+        program
+    );
+}
+
+// }}}
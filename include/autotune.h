@@ -0,0 +1,86 @@
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include <stdbool.h>
+#include "pigeon.h"
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Typedefs {{{
+
+typedef enum
+AutotuneState
+{
+    AUTOTUNE_IDLE,
+    AUTOTUNE_RUNNING,
+    AUTOTUNE_DONE,
+    AUTOTUNE_FAILED
+}
+AutotuneState;
+
+typedef enum
+AutotuneRule
+{
+    AUTOTUNE_ZIEGLER_NICHOLS,
+    AUTOTUNE_ZIEGLER_NICHOLS_PI,
+    AUTOTUNE_TYREUS_LUYBEN,
+    AUTOTUNE_NO_OVERSHOOT,
+    AUTOTUNE_NUMOFRULES
+}
+AutotuneRule;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Relay-feedback (Astrom-Hagglund) autotuner, run as a pipeline stage
+// placed after the controller it tunes. While running, it replaces the
+// controller's action with a relay of the given amplitude around the
+// action it found when started, oscillating the system about its current
+// target. The resulting gains are written through the setter.
+//
+ControlHandle
+autotuneInit(
+    ControlGainSetter,
+    ControlHandle control,
+    float amplitude,
+    float hysteresis
+);
+
+void
+autotuneReset(ControlHandle);
+
+float
+autotuneUpdate(ControlHandle, ControlSystem*);
+
+void
+autotuneSetup(ControlHandle, Portal*);
+
+void
+autotuneStart(ControlHandle, AutotuneRule);
+
+void
+autotuneStop(ControlHandle);
+
+AutotuneState
+autotuneGetState(ControlHandle);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,91 @@
+#ifndef BARRIER_H_
+#define BARRIER_H_
+
+#include <stdbool.h>
+#include "pigeon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define BARRIER_MAXSUBSYSTEMS 16
+#define BARRIER_NONE 0UL
+#define BARRIER_ALL ((BarrierSet)-1)
+
+
+
+// Typedefs {{{
+
+// Subsystems, one bit each, as barrierOf gives them.
+typedef unsigned long BarrierSet;
+
+// Whether all were ready before the timeout; which subsystem was the last
+// to become ready, or on a timeout one that never did, or -1 if there were
+// none; and how long the wait took, in milliseconds.
+typedef struct
+BarrierWait
+{
+    bool ready;
+    int last;
+    unsigned long waited;
+}
+BarrierWait;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// A readiness barrier across subsystems. Each registers once, from
+// anywhere, and then sets itself ready or not as that changes. Any number
+// of tasks can wait at once, each for any set of subsystems to all be
+// ready at the same moment.
+//
+// Returns the subsystem's id, or -1 if full. Subsystems start out not
+// ready.
+//
+int
+barrierRegister(const char * name);
+
+void
+barrierSet(int id, bool ready);
+
+BarrierSet
+barrierOf(int id);
+
+// The id of the subsystem of that name, or -1.
+int
+barrierFind(const char * name);
+
+const char *
+barrierName(int id);
+
+bool
+barrierIsReady(BarrierSet);
+
+// A blockTime of -1 waits forever.
+BarrierWait
+barrierWait(BarrierSet, const unsigned long blockTime);
+
+//
+// Reports which subsystems are ready, and how the last wait went, over
+// pigeon.
+//
+void
+barrierInit(Pigeon*);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
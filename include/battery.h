@@ -0,0 +1,38 @@
+#ifndef BATTERY_H_
+#define BATTERY_H_
+
+#include "pigeon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Methods {{{
+
+//
+// Samples and low-pass filters the main battery in the background.
+// The scale is what motor commands are multiplied by to give the torque
+// they would give at the nominal voltage.
+//
+void
+batteryInit(Pigeon*, float nominal, float smoothing, unsigned long period);
+
+float
+batteryGetVoltage();
+
+float
+batteryGetScale();
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -14,7 +14,10 @@ ControlSystem
 {
     unsigned long microTime;
     float dt;
+    // The setpoint, and where it is heading: a profiled setpoint only
+    // reaches the goal at the end of its profile.
     float target;
+    float goal;
     float measured;
     float derivative;
     float error;
@@ -36,6 +39,9 @@ typedef void
 typedef float
 (*TbhEstimator)(float target);
 
+typedef void
+(*ControlGainSetter)(ControlHandle, float gainP, float gainI, float gainD);
+
 ControlHandle
 pidInit(float gainP, float gainI, float gainD);
 
@@ -48,6 +54,9 @@ pidUpdate(ControlHandle, ControlSystem*);
 void
 pidSetup(ControlHandle, Portal*);
 
+void
+pidSetGains(ControlHandle, float gainP, float gainI, float gainD);
+
 ControlHandle
 tbhInit(float gain, float slew, TbhEstimator);
 
@@ -60,6 +69,9 @@ tbhUpdate(ControlHandle, ControlSystem*);
 void
 tbhSetup(ControlHandle, Portal*);
 
+void
+tbhSetGains(ControlHandle, float gainP, float gainI, float gainD);
+
 float
 tbhDummyEstimator(float target);
 
@@ -81,6 +93,57 @@ bangBangUpdate(ControlHandle, ControlSystem*);
 void
 bangBangSetup(ControlHandle, Portal*);
 
+ControlHandle
+feedforwardInit(
+    TbhEstimator,
+    ControlSetup,
+    ControlUpdater,
+    ControlResetter,
+    ControlHandle feedback
+);
+
+void
+feedforwardReset(ControlHandle);
+
+float
+feedforwardUpdate(ControlHandle, ControlSystem*);
+
+void
+feedforwardSetup(ControlHandle, Portal*);
+
+ControlHandle
+lowPassInit(float smoothing);
+
+void
+lowPassReset(ControlHandle);
+
+float
+lowPassUpdate(ControlHandle, ControlSystem*);
+
+void
+lowPassSetup(ControlHandle, Portal*);
+
+ControlHandle
+slewInit(float rate);
+
+void
+slewReset(ControlHandle);
+
+float
+slewUpdate(ControlHandle, ControlSystem*);
+
+void
+slewSetup(ControlHandle, Portal*);
+
+ControlHandle
+clampInit(float limit, float deadband);
+
+float
+clampUpdate(ControlHandle, ControlSystem*);
+
+void
+clampSetup(ControlHandle, Portal*);
+
 
 
 // End C++ export structure
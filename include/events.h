@@ -0,0 +1,91 @@
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define EVENTS_QUEUESIZE 16
+#define EVENTS_MAXTYPES 8
+// Tasks a signal wakes directly; any more waiting at once poll it.
+#define EVENTS_MAXWAITERS 8
+
+
+
+// Typedefs {{{
+
+typedef struct
+Event
+{
+    unsigned int type;
+    unsigned long microTime;
+}
+Event;
+
+typedef void (*EventHandler)(void * handle, Event);
+
+struct Signal;
+typedef struct Signal Signal;
+
+struct EventQueue;
+typedef struct EventQueue EventQueue;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// A signal wakes every task waiting on it, however many there are.
+// Read the generation before checking whatever condition is being waited
+// for, then wait on that generation, so a broadcast in between is not
+// missed. Returns whether the generation moved on before blockTime ran
+// out.
+//
+Signal *
+signalInit();
+
+unsigned long
+signalGeneration(Signal*);
+
+void
+signalBroadcast(Signal*);
+
+bool
+signalWait(Signal*, unsigned long generation, const unsigned long blockTime);
+
+//
+// Events are timestamped and queued without blocking on the handlers,
+// which run later in the queue's own dispatcher task.
+//
+EventQueue *
+eventQueueInit(unsigned int priority);
+
+void
+eventQueueOn(EventQueue*, unsigned int type, EventHandler, void * handle);
+
+void
+eventQueuePush(EventQueue*, unsigned int type);
+
+Event
+eventQueueLast(EventQueue*, unsigned int type);
+
+unsigned long
+eventQueueDropped(EventQueue*);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
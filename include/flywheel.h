@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include "pigeon.h"
 #include "control.h"
+#include "pipeline.h"
+#include "events.h"
 #include "shims.h"
 
 #ifdef __cplusplus
@@ -28,6 +30,14 @@ FlywheelController
 }
 FlywheelController;
 
+typedef enum
+FlywheelEvent
+{
+    FLYWHEEL_EVENT_READY,
+    FLYWHEEL_EVENT_ACTIVE
+}
+FlywheelEvent;
+
 typedef struct
 FlywheelSetup
 {
@@ -35,12 +45,9 @@ FlywheelSetup
     Pigeon * pigeon;
 
     float gearing;
-    float smoothing;
 
-    ControlSetup controlSetup;
-    ControlUpdater controlUpdater;
-    ControlResetter controlResetter;
-    ControlHandle control;
+    // Run in order every frame, terminated by a "~" key
+    PipelineStageSetup * stages;
 
     EncoderGetter encoderGetter;
     EncoderResetter encoderResetter;
@@ -48,16 +55,32 @@ FlywheelSetup
 
     MotorSetter motorSetters[8];
     MotorHandle motors[8];
+    // Optional, for setters that only post commands: when the first
+    // motor's commands reach its port, which the actuate and loop
+    // latencies then run to. Without it they end when the setters return.
+    MotorWriteGetter motorWriteGetter;
+
+    // Setpoint profile toward each new target: the most rpm/s it ramps
+    // at, and rpm/s^2 that ramp rate changes by. Zero leaves a limit out;
+    // with no rate limit the setpoint jumps straight to the target.
+    float profileRate;
+    float profileJerk;
 
     unsigned int priorityReady;
     unsigned int priorityActive;
+
+    // Bounds of the frame delay, which adapts every frame to how far the
+    // flywheel is from its ready thresholds.
     unsigned long frameDelayReady;
     unsigned long frameDelayActive;
 
+    // Ready once within both thresholds for checkCycle frames in a row
     float thresholdError;
     float thresholdDerivative;
     int checkCycle;
 
+    // Called from the flywheel's event dispatcher task, not its control task
+    unsigned int priorityEvents;
     FlywheelHandler onready;
     void * onreadyHandle;
     FlywheelHandler onactive;
@@ -81,6 +104,19 @@ void
 flywheelSet(Flywheel * flywheel, float rpm);
 
 void
+flywheelOn(Flywheel * flywheel, FlywheelEvent, EventHandler, void * handle);
+
+//
+// Seconds until ready, from a first-order fit of how the flywheel has
+// been approaching its targets: 0 when ready, negative until there is a
+// fit to go on. Updated every frame.
+//
+float
+flywheelGetEta(Flywheel * flywheel);
+
+// Each flywheel is also in the readiness barrier under its id (see
+// barrier.h), to be waited on along with other subsystems.
+bool
 waitUntilFlywheelReady(Flywheel * flywheel, const unsigned long blockTime);
 
 // }}}
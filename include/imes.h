@@ -0,0 +1,88 @@
+#ifndef IMES_H_
+#define IMES_H_
+
+#include <stdbool.h>
+
+#include "pigeon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define IMES_MAXDEVICES 8
+// Tries per transaction before a sweep gives up on a device.
+#define IMES_ATTEMPTS 2
+
+
+
+// Typedefs {{{
+
+typedef struct
+ImesReading
+{
+    // Raw IME units: ticks since reset, and rpm of the encoder wheel.
+    int count;
+    int velocity;
+    // micros() when last read successfully; readings are otherwise left as
+    // they were.
+    unsigned long microTime;
+}
+ImesReading;
+
+typedef struct
+ImesStats
+{
+    unsigned long reads;
+    // Transactions repeated after a failure, and sweeps in which the
+    // device failed every attempt.
+    unsigned long retries;
+    unsigned long errors;
+    // Errors since the last good read.
+    unsigned long failing;
+}
+ImesStats;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Central IME stage, owning the I2C chain. The chain is initialised here,
+// so call this from initialize() in place of imeInitializeAll. A sweep
+// task then, every period, reads the count and velocity of each IME
+// on it in turn, retrying failed transactions. Readers only copy the last
+// sweep's snapshot and never wait on the bus. Counts are never reset on
+// the device; readers keep their own zero, as the IME shim does. With no
+// IMEs found, there is no task and no portal.
+//
+void
+imesInit(Pigeon*, unsigned long period, unsigned int priority);
+
+// IMEs found on the chain by imesInit.
+unsigned int
+imesGetCount();
+
+ImesReading
+imesGet(unsigned char address);
+
+ImesStats
+imesGetStats(unsigned char address);
+
+unsigned long
+imesGetSweepCount();
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,70 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Bucket 0 counts under 16us, each next bucket doubles, and the last
+// counts everything from 16384us up.
+#define LATENCY_NUMOFBUCKETS 12
+
+
+
+// Typedefs {{{
+
+typedef struct
+LatencyHistogram
+{
+    const char * name;
+    unsigned long counts[LATENCY_NUMOFBUCKETS];
+    unsigned long total;
+    unsigned long max;
+}
+LatencyHistogram;
+
+// }}}
+
+
+
+// Methods {{{
+
+void
+latencyInit(LatencyHistogram*, const char * name);
+
+void
+latencyReset(LatencyHistogram*);
+
+void
+latencyRecord(LatencyHistogram*, unsigned long micros);
+
+// Upper bound of the bucket holding the given fraction of samples
+unsigned long
+latencyPercentile(LatencyHistogram*, float fraction);
+
+unsigned long
+latencyBucketLimit(int bucket);
+
+// "<name> n=<total> p50<.. p90<.. p99<.. max=.."
+void
+latencySummary(LatencyHistogram*, char * destination, size_t size);
+
+// "<name> <percent of samples in each bucket>..."
+void
+latencyBuckets(LatencyHistogram*, char * destination, size_t size);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,51 @@
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include "pigeon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define MONITOR_MAXTASKS 16
+
+
+
+// Methods {{{
+
+//
+// Tasks register themselves from inside their task function, before their
+// loop, and bracket each loop body with monitorBegin/monitorEnd. The
+// monitor task then reports each task's share of CPU time, along with the
+// task count, the heap left above the allocator's break, and the time no
+// monitored task accounts for. That is not idle time: unmonitored tasks
+// and interrupts take their share of it. Stack use is not reported: the
+// API gives no way to find where a task's stack begins.
+//
+// Returns a slot for monitorBegin/monitorEnd, or -1 if full.
+//
+int
+monitorRegister(const char * name);
+
+void
+monitorBegin(int slot);
+
+void
+monitorEnd(int slot);
+
+void
+monitorInit(Pigeon*, unsigned long period, unsigned int priority);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
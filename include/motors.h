@@ -0,0 +1,93 @@
+#ifndef MOTORS_H_
+#define MOTORS_H_
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define MOTORS_NUMOFPORTS 10
+
+
+
+// Typedefs {{{
+
+typedef enum
+MotorPriority
+{
+    MOTOR_PRIORITY_LOW,
+    MOTOR_PRIORITY_NORMAL,
+    MOTOR_PRIORITY_HIGH,
+    MOTOR_PRIORITY_OVERRIDE,
+    MOTOR_NUMOFPRIORITIES
+}
+MotorPriority;
+
+typedef struct
+MotorsWrite
+{
+    // micros() when the command was posted, and when the writer took it
+    // up: right after its motorSet, or if the port already held it, when
+    // the writer found so.
+    unsigned long postTime;
+    unsigned long writeTime;
+}
+MotorsWrite;
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Central motor output stage, owning every port that has been posted to.
+// Subsystems post commands without locking; a writer task runs every
+// period and, per port, writes the highest priority posted command, but
+// only when it differs from what the port holds, as read back with
+// motorGet, so that a command held across a kernel stop is sent again.
+// Posted ports with every command released are stopped. Ports never
+// posted to are left alone, for motorSet or motorSetter to drive.
+// Compensated ports have their commands scaled by the battery scale (see
+// battery.h).
+//
+void
+motorsInit(unsigned long period, unsigned int priority);
+
+void
+motorsPost(unsigned char channel, MotorPriority, int command);
+
+void
+motorsRelease(unsigned char channel, MotorPriority);
+
+void
+motorsCompensate(unsigned char channel, bool compensate);
+
+int
+motorsGetWritten(unsigned char channel);
+
+unsigned long
+motorsGetWriteCount();
+
+//
+// The last command posted at the priority that the writer has taken up.
+// False if none has been, or if posts at a higher priority have kept them
+// all from the port.
+//
+bool
+motorsGetWrite(unsigned char channel, MotorPriority, MotorsWrite*);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
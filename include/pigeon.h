@@ -107,6 +107,10 @@ portalIntHandler(void * handle, char * message, char * response);
 void
 portalUlongHandler(void * handle, char * message, char * response);
 
+// A ulong that must not be 0, such as a task's period: 0 is refused.
+void
+portalPeriodHandler(void * handle, char * message, char * response);
+
 void
 portalBoolHandler(void * handle, char * message, char * response);
 
@@ -0,0 +1,84 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include "pigeon.h"
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define PIPELINE_MAXSTAGES 8
+
+
+
+// Typedefs {{{
+
+struct Pipeline;
+typedef struct Pipeline Pipeline;
+
+//
+// A stage is anything with the ControlUpdater signature: filters,
+// controllers, limiters. Setup and resetter may be NULL. A fixed stage,
+// such as the final clamp, always runs after every other stage and cannot
+// be reordered or left out.
+//
+typedef struct
+PipelineStageSetup
+{
+    char * key;
+    ControlSetup setup;
+    ControlUpdater updater;
+    ControlResetter resetter;
+    ControlHandle handle;
+    bool fixed;
+}
+PipelineStageSetup;
+
+// }}}
+
+
+
+// Methods {{{
+
+Pipeline *
+pipelineInit(Portal*);
+
+void
+pipelineAdd(Pipeline*, PipelineStageSetup);
+
+void
+pipelineAddBatch(Pipeline*, PipelineStageSetup*);
+
+void
+pipelineUpdate(Pipeline*, ControlSystem*);
+
+void
+pipelineReset(Pipeline*);
+
+void
+pipelineGetOrder(Pipeline*, char * destination);
+
+//
+// Sets the order of the stages that are not fixed from a space-separated
+// list of keys; the fixed stages follow them. Fixed stages may be named,
+// so that a list read back from pipelineGetOrder can be set again. Returns
+// false and keeps the old order if a key is unknown or repeated, or if no
+// stage besides the fixed ones is named.
+//
+bool
+pipelineSetOrder(Pipeline*, char * sequence);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,86 @@
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <stdbool.h>
+
+#include "pigeon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define SAMPLER_MAXSENSORS 16
+
+
+
+// Typedefs {{{
+
+typedef struct
+SamplerSample
+{
+    int value;
+    // micros() at the middle of the read, and the sweep that took it.
+    unsigned long microTime;
+    unsigned long sweep;
+}
+SamplerSample;
+
+typedef int
+(*SamplerReader)(void * handle);
+
+// }}}
+
+
+
+// Methods {{{
+
+//
+// Central sensor stage. A sampler task calls every registered reader in
+// turn each period and publishes the whole sweep at once into a table
+// guarded by a sequence counter, so readers take no lock: they copy, and
+// copy again if a sweep was published meanwhile. The task must run above
+// every reader; a reader that preempts it mid-publish sleeps a tick.
+//
+void
+samplerInit(Pigeon*, unsigned long period, unsigned int priority);
+
+//
+// Returns the slot for the reader and handle, registering and reading it
+// once if it is new, or -1 if the table is full. Safe from any task.
+//
+int
+samplerAdd(SamplerReader, void * handle);
+
+//
+// As samplerAdd, for sensors slower than the sampler: the reader is only
+// called on the first sweep at least interval milliseconds after its last
+// read, and the slot keeps its sample and sweep in between.
+//
+int
+samplerAddEvery(SamplerReader, void * handle, unsigned long interval);
+
+SamplerSample
+samplerGet(int slot);
+
+//
+// Copies several slots from the same sweep.
+//
+void
+samplerGetMany(const int slots[], unsigned int count, SamplerSample samples[]);
+
+unsigned long
+samplerGetSweepCount();
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
@@ -0,0 +1,59 @@
+#ifndef SCHEDULE_H_
+#define SCHEDULE_H_
+
+#include <stdbool.h>
+#include "pigeon.h"
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#define SCHEDULE_MAXROWS 8
+
+
+
+// Methods {{{
+
+//
+// Gain schedule, run as a pipeline stage before the controller it
+// schedules. Holds a table of gains against target, kept sorted by
+// target, and whenever the goal changes writes the gains linearly
+// interpolated at the goal through the setter. Rows may be edited from
+// any task.
+//
+ControlHandle
+scheduleInit(ControlGainSetter, ControlHandle control);
+
+bool
+scheduleSetRow(ControlHandle, float target, float gainP, float gainI, float gainD);
+
+void
+scheduleReset(ControlHandle);
+
+float
+scheduleUpdate(ControlHandle, ControlSystem*);
+
+void
+scheduleSetup(ControlHandle, Portal*);
+
+//
+// ControlGainSetter that stores the gains in the row for the current
+// goal, so an autotuner can fill in the schedule one target at a time.
+//
+void
+scheduleSetGains(ControlHandle, float gainP, float gainI, float gainD);
+
+// }}}
+
+
+
+// End C++ export structure
+#ifdef __cplusplus
+}
+#endif
+
+// End include guard
+#endif
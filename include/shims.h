@@ -3,6 +3,7 @@
 
 #include <API.h>
 #include <stdbool.h>
+#include "motors.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +11,19 @@ extern "C" {
 
 
 
+#define SHIM_FITMAXWINDOW 16
+#define SHIM_ANALOGMAXOVERSAMPLE 16
+#define SHIM_ANALOGMAXWINDOW 16
+#define SHIM_ANALOGMAXPOINTS 8
+// Milliseconds between ultrasonic reads, and how many make the median.
+#define SHIM_ULTRASONICINTERVAL 50
+#define SHIM_ULTRASONICWINDOW 5
+// Sampler sweeps the gyro rate is fitted over: 100ms at the default 10ms
+// period, which makes the rate lag the turn by half of that.
+#define SHIM_GYROWINDOW 11
+
+
+
 extern const float SHIM_DEGREES_PER_REV;
 extern const float SHIM_RADIANS_PER_REV;
 
@@ -26,27 +40,89 @@ extern const float ENCODER_GEARING_IME_393_SPEED;
 typedef void * EncoderHandle;
 typedef void * MotorHandle;
 typedef void * DigitalHandle;
+typedef void * AnalogHandle;
+typedef void * GyroHandle;
+typedef void * UltrasonicHandle;
 
 typedef struct
 EncoderReading
 {
     float revolutions;
     float rpm;
+    // micros() when the count was read
+    unsigned long microTime;
 }
 EncoderReading;
 
 typedef EncoderReading
 (*EncoderGetter)(EncoderHandle handle);
 
+// Revolutions only, with no effect on the handle, so position can be
+// polled as often as wanted without disturbing a speed reader.
+typedef float
+(*EncoderPositionGetter)(EncoderHandle handle);
+
 typedef void
 (*EncoderResetter)(EncoderHandle handle);
 
 typedef void
 (*MotorSetter)(MotorHandle handle, int command);
 
+// When the last command set through the handle reached the port, for
+// setters that only post it; false until one has.
+typedef bool
+(*MotorWriteGetter)(MotorHandle handle, MotorsWrite * write);
+
 typedef bool
 (*DigitalGetter)(DigitalHandle handle);
 
+typedef float
+(*AnalogGetter)(AnalogHandle handle);
+
+typedef enum
+AnalogFilter
+{
+    ANALOG_FILTER_MEAN,
+    ANALOG_FILTER_MEDIAN
+}
+AnalogFilter;
+
+typedef struct
+GyroReading
+{
+    float degrees;
+    float rate;
+    unsigned long microTime;
+}
+GyroReading;
+
+typedef struct
+UltrasonicReading
+{
+    float centimeters;
+    bool found;
+    unsigned long microTime;
+}
+UltrasonicReading;
+
+typedef GyroReading
+(*GyroGetter)(GyroHandle handle);
+
+typedef void
+(*GyroResetter)(GyroHandle handle);
+
+typedef UltrasonicReading
+(*UltrasonicGetter)(UltrasonicHandle handle);
+
+// A raw reading, in counts, and what it stands for.
+typedef struct
+AnalogPoint
+{
+    float raw;
+    float value;
+}
+AnalogPoint;
+
 typedef enum
 MotorType
 {
@@ -56,30 +132,79 @@ MotorType
 }
 MotorType;
 
+//
+// Sensor shims read the sampler's table (see sampler.h) without locking,
+// and samplerInit must have been called for it to move. Each handle keeps
+// its own zero and speed, so take one per reader rather than sharing;
+// resetting zeroes the handle and leaves the sensor alone.
+//
+// The rpm is over the time between the samples behind this and the last
+// read of the handle.
+//
 EncoderReading
 encoderGetter(EncoderHandle);
 
+float
+encoderPositionGetter(EncoderHandle);
+
 void
 encoderResetter(EncoderHandle);
 
 EncoderHandle
 encoderGetHandle(Encoder);
 
+//
+// As encoderGetter, but the rpm is the least squares slope through the
+// last window sweeps read (2 to SHIM_FITMAXWINDOW), each as stamped by the
+// sampler. Read at a steady period, the rpm lags by (window - 1) / 2
+// periods, and its noise falls as the window grows.
+//
+EncoderReading
+encoderFitGetter(EncoderHandle);
+
+float
+encoderFitPositionGetter(EncoderHandle);
+
+void
+encoderFitResetter(EncoderHandle);
+
+EncoderHandle
+encoderFitGetHandle(Encoder, unsigned int window);
+
+//
+// Samples the IME stage's last sweep (see imes.h), so never touches the
+// bus; imesInit must have been called.
+//
 EncoderReading
 imeGetter(EncoderHandle);
 
+float
+imePositionGetter(EncoderHandle);
+
 void
 imeResetter(EncoderHandle);
 
 EncoderHandle
 imeGetHandle(unsigned char address, MotorType);
 
+// Writes straight to the port, so only for ports nothing posts to: once a
+// port is posted to, the motors writer owns it and overwrites this.
 void
 motorSetter(MotorHandle, int command);
 
 MotorHandle
 motorGetHandle(unsigned char channel, bool reversed);
 
+// Posts to the central motor output stage (see motors.h)
+void
+motorPostSetter(MotorHandle, int command);
+
+MotorHandle
+motorPostGetHandle(unsigned char channel, bool reversed, MotorPriority);
+
+bool
+motorPostWriteGetter(MotorHandle, MotorsWrite*);
+
 bool
 digitalGetter(DigitalHandle);
 
@@ -90,7 +215,58 @@ bool
 encoderRangeGetter(DigitalHandle);
 
 DigitalHandle
-encoderRangeGetHandle(EncoderGetter, EncoderHandle, float upper, float lower);
+encoderRangeGetHandle(EncoderPositionGetter, EncoderHandle, float upper, float lower);
+
+//
+// Each sweep of the sampler reads the channel oversample times (1 to
+// SHIM_ANALOGMAXOVERSAMPLE) and averages them, then filters the last
+// window (1 to SHIM_ANALOGMAXWINDOW) of those averages, so reading costs
+// no more than a table lookup. Means are kept as a running sum; medians
+// sort a copy of the window. Raw readings are in counts, to a sixteenth.
+//
+float
+analogGetter(AnalogHandle);
+
+AnalogHandle
+analogGetHandle(unsigned char channel, unsigned int oversample, AnalogFilter, unsigned int window);
+
+//
+// Maps readings through the points, which must be in rising order of raw
+// count, linearly between them and along the end segments beyond. Fewer
+// than two points leave readings raw. Set before the handle is read.
+//
+void
+analogSetCalibration(AnalogHandle, const AnalogPoint points[], unsigned int count);
+
+//
+// Read by the sampler every sweep. Degrees and rate (per second) have the
+// gyro's drift taken out: whenever the gyro turns no more than a couple of
+// degrees over a couple of seconds, the robot is taken to be still and the
+// turn to be drift, and the drift estimate moves toward it. The gyro must
+// start still; turns slower than a degree a second read as drift. The
+// rate is the least squares slope over the last SHIM_GYROWINDOW sweeps, so
+// it lags by half the window, 50ms at the default sampler period.
+//
+GyroReading
+gyroGetter(GyroHandle);
+
+void
+gyroResetter(GyroHandle);
+
+GyroHandle
+gyroGetHandle(Gyro);
+
+//
+// Read by the sampler every SHIM_ULTRASONICINTERVAL, and reported as the
+// median of the last SHIM_ULTRASONICWINDOW echoes, so that lone spikes and
+// dropouts are passed over. Not found once the last
+// SHIM_ULTRASONICWINDOW reads have all come back empty.
+//
+UltrasonicReading
+ultrasonicGetter(UltrasonicHandle);
+
+UltrasonicHandle
+ultrasonicGetHandle(Ultrasonic);
 
 
 
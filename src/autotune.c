@@ -0,0 +1,393 @@
+#include "autotune.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#include "control.h"
+#include "pigeon.h"
+#include "utils.h"
+
+
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+Autotune
+{
+    Portal * portal;
+    ControlGainSetter setGains;
+    ControlHandle control;
+
+    float amplitude;
+    float hysteresis;
+    int cycles;
+    float timeout;
+    AutotuneRule rule;
+
+    // Requests come from other tasks and are picked up on the next frame.
+    volatile bool startRequested;
+    volatile bool stopRequested;
+
+    AutotuneState state;
+    float bias;
+    bool high;
+    float elapsed;
+    float lastRise;
+    float peakHigh;
+    float peakLow;
+    int samples;
+    float amplitudeSum;
+    float periodSum;
+
+    float ultimateGain;
+    float ultimatePeriod;
+}
+Autotune;
+
+// }}}
+
+
+
+// Private functions - forward declarations {{{
+
+static void begin(Autotune*, ControlSystem*);
+static void finish(Autotune*, AutotuneState);
+static void applyRule(Autotune*);
+static void stateHandler(void * handle, char * message, char * response);
+static void ruleHandler(void * handle, char * message, char * response);
+static void cyclesHandler(void * handle, char * message, char * response);
+
+static const char * stateNames[] =
+{
+    [AUTOTUNE_IDLE] = "idle",
+    [AUTOTUNE_RUNNING] = "running",
+    [AUTOTUNE_DONE] = "done",
+    [AUTOTUNE_FAILED] = "failed"
+};
+
+static const char * ruleNames[AUTOTUNE_NUMOFRULES] =
+{
+    [AUTOTUNE_ZIEGLER_NICHOLS] = "zn",
+    [AUTOTUNE_ZIEGLER_NICHOLS_PI] = "zn-pi",
+    [AUTOTUNE_TYREUS_LUYBEN] = "tl",
+    [AUTOTUNE_NO_OVERSHOOT] = "no-overshoot"
+};
+
+// }}}
+
+
+
+// Public methods {{{
+
+ControlHandle
+autotuneInit(
+    ControlGainSetter setGains,
+    ControlHandle control,
+    float amplitude,
+    float hysteresis
+){
+    Autotune * at = malloc(sizeof(Autotune));
+    at->portal = NULL;
+    at->setGains = setGains;
+    at->control = control;
+    at->amplitude = amplitude;
+    at->hysteresis = hysteresis;
+    at->cycles = 4;
+    at->timeout = 30.0f;
+    at->rule = AUTOTUNE_ZIEGLER_NICHOLS;
+    at->ultimateGain = 0.0f;
+    at->ultimatePeriod = 0.0f;
+    autotuneReset(at);
+    return at;
+}
+
+void
+autotuneReset(ControlHandle handle)
+{
+    Autotune * at = handle;
+    at->startRequested = false;
+    at->stopRequested = false;
+    at->state = AUTOTUNE_IDLE;
+    portalUpdate(at->portal, "autotune");
+}
+
+float
+autotuneUpdate(ControlHandle handle, ControlSystem * system)
+{
+    Autotune * at = handle;
+
+    if (at->stopRequested)
+    {
+        at->stopRequested = false;
+        if (at->state == AUTOTUNE_RUNNING) finish(at, AUTOTUNE_IDLE);
+    }
+    if (at->startRequested)
+    {
+        at->startRequested = false;
+        begin(at, system);
+    }
+    if (at->state != AUTOTUNE_RUNNING) return system->action;
+
+    at->elapsed += system->dt;
+    if (at->elapsed > at->timeout)
+    {
+        finish(at, AUTOTUNE_FAILED);
+        return system->action;
+    }
+
+    if (system->measured > at->peakHigh) at->peakHigh = system->measured;
+    if (system->measured < at->peakLow) at->peakLow = system->measured;
+
+    if (!at->high && system->error < -at->hysteresis)
+    {
+        // Rising switch: one full oscillation since the last one.
+        at->high = true;
+        if (at->lastRise >= 0.0f)
+        {
+            // The first cycle is still settling from the start, skip it.
+            at->samples++;
+            if (at->samples > 1)
+            {
+                at->periodSum += at->elapsed - at->lastRise;
+                at->amplitudeSum += 0.5f * (at->peakHigh - at->peakLow);
+            }
+        }
+        at->lastRise = at->elapsed;
+        at->peakHigh = system->measured;
+        at->peakLow = system->measured;
+
+        if (at->samples > at->cycles)
+        {
+            // Nothing to average unless a cycle after the first was timed.
+            if (at->samples > 1)
+            {
+                applyRule(at);
+                finish(at, AUTOTUNE_DONE);
+            }
+            else finish(at, AUTOTUNE_FAILED);
+            return system->action;
+        }
+    }
+    else if (at->high && system->error > at->hysteresis)
+    {
+        at->high = false;
+    }
+
+    float relay = at->high? at->amplitude : -at->amplitude;
+    system->action = at->bias + relay;
+    return system->action;
+}
+
+void
+autotuneSetup(ControlHandle handle, Portal * portal)
+{
+    Autotune * at = handle;
+    at->portal = portal;
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "autotune",
+            .handler = stateHandler,
+            .handle = at,
+            .onchange = true
+        },
+        {
+            .key = "autotune-rule",
+            .handler = ruleHandler,
+            .handle = at
+        },
+        {
+            .key = "autotune-amplitude",
+            .handler = portalFloatHandler,
+            .handle = &at->amplitude
+        },
+        {
+            .key = "autotune-hysteresis",
+            .handler = portalFloatHandler,
+            .handle = &at->hysteresis
+        },
+        {
+            .key = "autotune-cycles",
+            .handler = cyclesHandler,
+            .handle = at
+        },
+        {
+            .key = "autotune-timeout",
+            .handler = portalFloatHandler,
+            .handle = &at->timeout
+        },
+        {
+            .key = "autotune-ku",
+            .handler = portalFloatHandler,
+            .handle = &at->ultimateGain
+        },
+        {
+            .key = "autotune-tu",
+            .handler = portalFloatHandler,
+            .handle = &at->ultimatePeriod
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+}
+
+void
+autotuneStart(ControlHandle handle, AutotuneRule rule)
+{
+    Autotune * at = handle;
+    if (rule < AUTOTUNE_NUMOFRULES) at->rule = rule;
+    at->startRequested = true;
+}
+
+void
+autotuneStop(ControlHandle handle)
+{
+    Autotune * at = handle;
+    at->stopRequested = true;
+}
+
+AutotuneState
+autotuneGetState(ControlHandle handle)
+{
+    Autotune * at = handle;
+    return at->state;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+begin(Autotune * at, ControlSystem * system)
+{
+    // Oscillate around whatever the controller was holding.
+    at->bias = system->action;
+    at->high = system->error < 0.0f;
+    at->elapsed = 0.0f;
+    at->lastRise = -1.0f;
+    at->peakHigh = system->measured;
+    at->peakLow = system->measured;
+    at->samples = 0;
+    at->amplitudeSum = 0.0f;
+    at->periodSum = 0.0f;
+    at->state = AUTOTUNE_RUNNING;
+    portalUpdate(at->portal, "autotune");
+}
+
+static void
+finish(Autotune * at, AutotuneState state)
+{
+    at->state = state;
+    portalUpdate(at->portal, "autotune");
+}
+
+static void
+applyRule(Autotune * at)
+{
+    int samples = at->samples - 1;
+    float amplitude = at->amplitudeSum / samples;
+    float period = at->periodSum / samples;
+
+    // Describing function of a relay with hysteresis.
+    float squared = amplitude * amplitude - at->hysteresis * at->hysteresis;
+    float effective = squared > 0.0f? sqrtf(squared) : amplitude;
+    float ku = 4.0f * at->amplitude / (PI * effective);
+    float tu = period;
+
+    at->ultimateGain = ku;
+    at->ultimatePeriod = tu;
+    portalUpdate(at->portal, "autotune-ku");
+    portalUpdate(at->portal, "autotune-tu");
+
+    float gainP = 0.0f;
+    float gainI = 0.0f;
+    float gainD = 0.0f;
+    switch (at->rule)
+    {
+    case AUTOTUNE_ZIEGLER_NICHOLS:
+        gainP = 0.6f * ku;
+        gainI = 1.2f * ku / tu;
+        gainD = 0.075f * ku * tu;
+        break;
+    case AUTOTUNE_ZIEGLER_NICHOLS_PI:
+        gainP = 0.45f * ku;
+        gainI = 0.54f * ku / tu;
+        break;
+    case AUTOTUNE_TYREUS_LUYBEN:
+        gainP = ku / 2.2f;
+        gainI = gainP / (2.2f * tu);
+        gainD = gainP * tu / 6.3f;
+        break;
+    case AUTOTUNE_NO_OVERSHOOT:
+        gainP = 0.2f * ku;
+        gainI = 0.4f * ku / tu;
+        gainD = 0.2f * ku * tu / 3.0f;
+        break;
+    default:
+        return;
+    }
+    at->setGains(at->control, gainP, gainI, gainD);
+}
+
+static void
+stateHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    Autotune * at = handle;
+    if (message == NULL) strcpy(response, stateNames[at->state]);
+    else if (strcmp(message, "true") == 0) at->startRequested = true;
+    else if (strcmp(message, "false") == 0) at->stopRequested = true;
+}
+
+static void
+ruleHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    Autotune * at = handle;
+    if (message == NULL)
+    {
+        strcpy(response, ruleNames[at->rule]);
+        return;
+    }
+    for (int rule = 0; rule < AUTOTUNE_NUMOFRULES; rule++)
+    {
+        if (strcmp(message, ruleNames[rule]) == 0) at->rule = rule;
+    }
+}
+
+// At least one cycle, as the rule averages over them.
+static void
+cyclesHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    Autotune * at = handle;
+    if (message == NULL)
+    {
+        sprintf(response, "%d", at->cycles);
+        return;
+    }
+    unsigned long cycles = 1;
+    if (message[0] != '-' && !stringToUlong(message, &cycles)) return;
+    if (cycles < 1) cycles = 1;
+    if (cycles > INT_MAX) cycles = INT_MAX;
+    at->cycles = cycles;
+}
+
+// }}}
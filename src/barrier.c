@@ -0,0 +1,269 @@
+#include "barrier.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pigeon.h"
+#include "events.h"
+#include "utils.h"
+
+
+#define MAXSUBSYSTEMS BARRIER_MAXSUBSYSTEMS
+#define LINESIZE PIGEON_LINESIZE
+#define UNUSED(x) (void)(x)
+
+
+// Private functions, forward declarations {{{
+
+static void setup();
+static BarrierSet registered(BarrierSet);
+static void setupPortal(Pigeon*);
+static void readyHandler(void * handle, char * message, char * response);
+static void lastWaitHandler(void * handle, char * message, char * response);
+
+static const char * names[MAXSUBSYSTEMS];
+static unsigned long readyTimes[MAXSUBSYSTEMS];
+static volatile BarrierSet readySet = BARRIER_NONE;
+static volatile int subsystemCount = 0;
+static Mutex mutex = NULL;
+static Signal * readySignal = NULL;
+
+static Portal * portal = NULL;
+static BarrierWait lastWait = {false, -1, 0};
+
+// }}}
+
+
+
+// Public methods {{{
+
+int
+barrierRegister(const char * name)
+{
+    setup();
+
+    mutexTake(mutex, -1);
+    if (subsystemCount >= MAXSUBSYSTEMS)
+    {
+        mutexGive(mutex);
+        return -1;
+    }
+    int id = subsystemCount;
+    names[id] = name;
+    readyTimes[id] = 0;
+    subsystemCount++;
+    mutexGive(mutex);
+
+    return id;
+}
+
+void
+barrierSet(int id, bool ready)
+{
+    if (id < 0 || id >= subsystemCount) return;
+    BarrierSet bit = barrierOf(id);
+
+    mutexTake(mutex, -1);
+    bool wasReady = (readySet & bit) != 0;
+    if (ready) readySet |= bit;
+    else readySet &= ~bit;
+    if (ready && !wasReady) readyTimes[id] = micros();
+    mutexGive(mutex);
+
+    if (ready == wasReady) return;
+    // Only becoming ready can let a waiter through.
+    if (ready) signalBroadcast(readySignal);
+    portalUpdate(portal, "ready");
+}
+
+BarrierSet
+barrierOf(int id)
+{
+    if (id < 0 || id >= MAXSUBSYSTEMS) return BARRIER_NONE;
+    return 1UL << id;
+}
+
+int
+barrierFind(const char * name)
+{
+    for (int i = 0; i < subsystemCount; i++)
+    {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+const char *
+barrierName(int id)
+{
+    if (id < 0 || id >= subsystemCount) return NULL;
+    return names[id];
+}
+
+bool
+barrierIsReady(BarrierSet set)
+{
+    set = registered(set);
+    return (readySet & set) == set;
+}
+
+BarrierWait
+barrierWait(BarrierSet set, const unsigned long blockTime)
+{
+    setup();
+    set = registered(set);
+
+    unsigned long start = millis();
+    bool ready = true;
+    while (true)
+    {
+        unsigned long generation = signalGeneration(readySignal);
+        if ((readySet & set) == set) break;
+
+        unsigned long remaining = blockTime;
+        if (blockTime != (unsigned long)-1)
+        {
+            unsigned long elapsed = millis() - start;
+            if (elapsed >= blockTime)
+            {
+                ready = false;
+                break;
+            }
+            remaining = blockTime - elapsed;
+        }
+        signalWait(readySignal, generation, remaining);
+    }
+
+    BarrierWait wait =
+    {
+        .ready = ready,
+        .last = -1,
+        .waited = millis() - start
+    };
+
+    // The latest to become ready, or else the first still not ready.
+    mutexTake(mutex, -1);
+    for (int i = 0; i < subsystemCount; i++)
+    {
+        BarrierSet bit = barrierOf(i);
+        if ((set & bit) == 0) continue;
+        if (!ready)
+        {
+            if ((readySet & bit) != 0) continue;
+            wait.last = i;
+            break;
+        }
+        if (wait.last < 0 || (long)(readyTimes[i] - readyTimes[wait.last]) >= 0)
+        {
+            wait.last = i;
+        }
+    }
+    lastWait = wait;
+    mutexGive(mutex);
+
+    portalUpdate(portal, "last-wait");
+    return wait;
+}
+
+void
+barrierInit(Pigeon * pigeon)
+{
+    if (portal != NULL) return;
+    setup();
+    setupPortal(pigeon);
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+// Subsystems may register before barrierInit, so whichever comes first
+// makes the locks.
+static void
+setup()
+{
+    if (mutex == NULL) mutex = mutexCreate();
+    if (readySignal == NULL) readySignal = signalInit();
+}
+
+// Only registered subsystems count, so BARRIER_ALL means all of those.
+static BarrierSet
+registered(BarrierSet set)
+{
+    int count = subsystemCount;
+    return count < MAXSUBSYSTEMS? set & ((1UL << count) - 1) : set;
+}
+
+static void
+setupPortal(Pigeon * pigeon)
+{
+    portal = pigeonCreatePortal(pigeon, "barrier");
+
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "ready",
+            .handler = readyHandler,
+            .handle = NULL,
+            .onchange = true
+        },
+        {
+            .key = "last-wait",
+            .handler = lastWaitHandler,
+            .handle = NULL,
+            .onchange = true
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+    portalReady(portal);
+}
+
+// The ready subsystems' names, or "none"
+static void
+readyHandler(void * handle, char * message, char * response)
+{
+    UNUSED(handle);
+    UNUSED(message);
+    if (response == NULL) return;
+
+    response[0] = '\0';
+    for (int i = 0; i < subsystemCount; i++)
+    {
+        if ((readySet & barrierOf(i)) == 0) continue;
+        if (response[0] != '\0') stringAppend(response, " ", LINESIZE);
+        stringAppend(response, names[i], LINESIZE);
+    }
+    if (response[0] == '\0') strcpy(response, "none");
+}
+
+// "ready <last> <milliseconds>", or "timeout <not ready> <milliseconds>"
+static void
+lastWaitHandler(void * handle, char * message, char * response)
+{
+    UNUSED(handle);
+    UNUSED(message);
+    if (response == NULL) return;
+
+    const char * last = lastWait.last >= 0? names[lastWait.last] : "none";
+    snprintf(
+        response,
+        LINESIZE,
+        "%s %s %lu",
+        lastWait.ready? "ready" : "timeout",
+        last,
+        lastWait.waited
+    );
+}
+
+// }}}
@@ -0,0 +1,156 @@
+#include "battery.h"
+
+#include <API.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pigeon.h"
+#include "monitor.h"
+#include "utils.h"
+
+
+// Below this, the reading is from USB power or a fault, not the battery.
+#define MINIMUM_VOLTAGE 3.0f
+#define MAXIMUM_SCALE 1.5f
+#define STACKSIZE (TASK_MINIMAL_STACK_SIZE * 4)
+#define UNUSED(x) (void)(x)
+
+
+static Portal * portal = NULL;
+static TaskHandle sampler = NULL;
+
+static unsigned long period = 50;
+static unsigned long microTime = 0;
+static float nominal = 7.2f;
+static float smoothing = 1.0f;
+static float raw = 0.0f;
+static float voltage = 0.0f;
+static float scale = 1.0f;
+
+static void task(void * data);
+static void update();
+static void setupPortal(Pigeon*);
+
+
+void
+batteryInit(Pigeon * pigeon, float nominalVoltage, float smoothingTime, unsigned long samplePeriod)
+{
+    if (sampler != NULL) return;
+
+    nominal = nominalVoltage;
+    smoothing = smoothingTime;
+    period = samplePeriod;
+
+    raw = powerLevelMain() / 1000.0f;
+    voltage = raw;
+    microTime = micros();
+
+    setupPortal(pigeon);
+    sampler = taskCreate(task, STACKSIZE, NULL, TASK_PRIORITY_DEFAULT);
+}
+
+float
+batteryGetVoltage()
+{
+    return voltage;
+}
+
+float
+batteryGetScale()
+{
+    return scale;
+}
+
+
+static void
+task(void * data)
+{
+    UNUSED(data);
+    int slot = monitorRegister("battery");
+    unsigned long wakeTime = millis();
+    while (true)
+    {
+        monitorBegin(slot);
+        update();
+        portalFlush(portal);
+        monitorEnd(slot);
+        taskDelayUntil(&wakeTime, period);
+    }
+}
+
+static void
+update()
+{
+    float dt = timeUpdate(&microTime);
+    raw = powerLevelMain() / 1000.0f;
+
+    float weight = smoothing > dt? dt / smoothing : 1.0f;
+    voltage += (raw - voltage) * weight;
+
+    float newScale = 1.0f;
+    if (voltage > MINIMUM_VOLTAGE) newScale = nominal / voltage;
+    if (newScale > MAXIMUM_SCALE) newScale = MAXIMUM_SCALE;
+
+    // Single word write; motor writers read it without locking.
+    scale = newScale;
+
+    portalUpdate(portal, "raw");
+    portalUpdate(portal, "voltage");
+    portalUpdate(portal, "scale");
+}
+
+static void
+setupPortal(Pigeon * pigeon)
+{
+    portal = pigeonCreatePortal(pigeon, "battery");
+
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "raw",
+            .handler = portalFloatHandler,
+            .handle = &raw
+        },
+        {
+            .key = "voltage",
+            .handler = portalFloatHandler,
+            .handle = &voltage,
+            .stream = true
+        },
+        {
+            .key = "scale",
+            .handler = portalFloatHandler,
+            .handle = &scale,
+            .stream = true
+        },
+        {
+            .key = "nominal",
+            .handler = portalFloatHandler,
+            .handle = &nominal
+        },
+        {
+            .key = "smoothing",
+            .handler = portalFloatHandler,
+            .handle = &smoothing
+        },
+        {
+            .key = "period",
+            .handler = portalPeriodHandler,
+            .handle = &period
+        },
+        {
+            .key = "keys",
+            .handler = portalStreamKeyHandler,
+            .handle = portal
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+    portalReady(portal);
+}
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdlib.h>
 #include <stdbool.h>
 
@@ -7,6 +8,9 @@
 
 
 #define UNUSED(x) (void)(x)
+// Seconds within which the feedforward must close a gap by itself before
+// the feedback controller is held off it.
+#define FEEDFORWARD_HORIZON 2.0f
 
 
 // PID Controller {{{
@@ -49,11 +53,14 @@ pidUpdate(ControlHandle handle, ControlSystem * system)
 
     pid->integral += system->error * system->dt;
 
+    // Error is measured - target, so all parts push against it. The D
+    // part acts on the measurement, not the error, so that a step or ramp
+    // of the setpoint does not kick it.
     float partP = pid->gainP * system->error;
-    float partI = pid->gainI * system->error;
-    float partD = pid->gainD * system->error;
+    float partI = pid->gainI * pid->integral;
+    float partD = pid->gainD * system->derivative;
 
-    system->action = partP + partI + partD;
+    system->action = -(partP + partI + partD);
 
     portalUpdate(pid->portal, "integral");
 
@@ -98,6 +105,18 @@ pidSetup(ControlHandle handle, Portal * portal)
     portalAddBatch(portal, setups);
 }
 
+void
+pidSetGains(ControlHandle handle, float gainP, float gainI, float gainD)
+{
+    Pid * pid = handle;
+    pid->gainP = gainP;
+    pid->gainI = gainI;
+    pid->gainD = gainD;
+    portalUpdate(pid->portal, "gain-p");
+    portalUpdate(pid->portal, "gain-i");
+    portalUpdate(pid->portal, "gain-d");
+}
+
 // }}}
 
 
@@ -227,6 +246,24 @@ tbhSetup(ControlHandle handle, Portal * portal)
     portalAddBatch(portal, setups);
 }
 
+// TBH (with the take-back-half part disabled) only integrates the error,
+// so its gain is an integral gain, and it takes the rule's I gain alone.
+// The rules size that gain for a loop that also has a P part, so on its
+// own it is on the aggressive side (ZN's 1.2Ku/Tu most of all); it is
+// kept because TBH bounds its own rate with the slew, so a large gain only
+// matters close to the target, and because the flywheel runs it under the
+// feedforward, which leaves it to trim what the estimator misses. For a
+// gentler loop, tune with the zn-pi or no-overshoot rule.
+void
+tbhSetGains(ControlHandle handle, float gainP, float gainI, float gainD)
+{
+    UNUSED(gainP);
+    UNUSED(gainD);
+    Tbh * tbh = handle;
+    tbh->gain = gainI;
+    portalUpdate(tbh->portal, "gain");
+}
+
 float
 tbhDummyEstimator(float target)
 {
@@ -324,3 +361,316 @@ bangBangSetup(ControlHandle handle, Portal * portal)
 }
 
 // }}}
+
+
+// Feedforward Controller {{{
+
+//
+// Wraps a feedback controller, adding the estimator's open-loop action
+// for the target so the feedback controller only corrects the residual.
+// The previous frame's (possibly clamped) action less its feedforward is
+// the residual, so integrating controllers do not wind up past the clamp.
+//
+typedef struct
+Feedforward
+{
+    Portal * portal;
+    TbhEstimator estimator;
+    ControlSetup feedbackSetup;
+    ControlUpdater feedbackUpdate;
+    ControlResetter feedbackReset;
+    ControlHandle feedback;
+    float feedforward;
+    float lastGoal;
+}
+Feedforward;
+
+ControlHandle
+feedforwardInit(
+    TbhEstimator estimator,
+    ControlSetup feedbackSetup,
+    ControlUpdater feedbackUpdate,
+    ControlResetter feedbackReset,
+    ControlHandle feedback
+){
+    Feedforward * ff = malloc(sizeof(Feedforward));
+    ff->portal = NULL;
+    ff->estimator = estimator;
+    ff->feedbackSetup = feedbackSetup;
+    ff->feedbackUpdate = feedbackUpdate;
+    ff->feedbackReset = feedbackReset;
+    ff->feedback = feedback;
+    feedforwardReset(ff);
+    return ff;
+}
+
+void
+feedforwardReset(ControlHandle handle)
+{
+    Feedforward * ff = handle;
+    ff->feedforward = 0.0f;
+    ff->lastGoal = 0.0f;
+    if (ff->feedbackReset != NULL) ff->feedbackReset(ff->feedback);
+    portalUpdate(ff->portal, "feedforward");
+}
+
+float
+feedforwardUpdate(ControlHandle handle, ControlSystem * system)
+{
+    Feedforward * ff = handle;
+
+    system->action -= ff->feedforward;
+    // A new goal starts from its own feedforward, and the feedback
+    // controller is held while the flywheel is closing on the target by
+    // itself, at a rate that would reach it within the horizon, so that a
+    // step does not wind it up on the way. The goal, not the target, marks
+    // a new setpoint: a profiled target moves on every frame of its ramp.
+    if (system->goal != ff->lastGoal)
+    {
+        system->action = 0.0f;
+        ff->lastGoal = system->goal;
+    }
+    bool closing =
+        system->error * system->derivative < 0.0f &&
+        fabsf(system->error) < FEEDFORWARD_HORIZON * fabsf(system->derivative);
+    if (!closing) ff->feedbackUpdate(ff->feedback, system);
+
+    ff->feedforward = ff->estimator(system->target);
+    system->action += ff->feedforward;
+
+    return system->action;
+}
+
+void
+feedforwardSetup(ControlHandle handle, Portal * portal)
+{
+    Feedforward * ff = handle;
+    ff->portal = portal;
+    if (ff->feedbackSetup != NULL) ff->feedbackSetup(ff->feedback, portal);
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "feedforward",
+            .handler = portalFloatHandler,
+            .handle = &ff->feedforward
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+}
+
+// }}}
+
+
+// Low-pass Filter Stage {{{
+
+typedef struct
+LowPass
+{
+    float smoothing;
+    float measured;
+    float derivative;
+}
+LowPass;
+
+ControlHandle
+lowPassInit(float smoothing)
+{
+    LowPass * lp = malloc(sizeof(LowPass));
+    lp->smoothing = smoothing;
+    lowPassReset(lp);
+    return lp;
+}
+
+void
+lowPassReset(ControlHandle handle)
+{
+    LowPass * lp = handle;
+    lp->measured = 0.0f;
+    lp->derivative = 0.0f;
+}
+
+float
+lowPassUpdate(ControlHandle handle, ControlSystem * system)
+{
+    LowPass * lp = handle;
+    if (system->dt <= 0.0f) return system->action;
+
+    // system->measured comes in raw, and leaves smoothed
+    float measureChange = (system->measured - lp->measured);
+    measureChange *= system->dt / lp->smoothing;
+    float derivative = measureChange / system->dt;
+    float derivativeChange = (derivative - lp->derivative);
+    derivativeChange *= system->dt / lp->smoothing;
+
+    lp->measured += measureChange;
+    lp->derivative += derivativeChange;
+
+    system->measured = lp->measured;
+    system->derivative = lp->derivative;
+    system->error = system->measured - system->target;
+
+    return system->action;
+}
+
+void
+lowPassSetup(ControlHandle handle, Portal * portal)
+{
+    LowPass * lp = handle;
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "smoothing",
+            .handler = portalFloatHandler,
+            .handle = &lp->smoothing
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+}
+
+// }}}
+
+
+// Slew Rate Limiter Stage {{{
+
+typedef struct
+Slew
+{
+    float rate;
+    float lastAction;
+}
+Slew;
+
+ControlHandle
+slewInit(float rate)
+{
+    Slew * slew = malloc(sizeof(Slew));
+    slew->rate = rate;
+    slewReset(slew);
+    return slew;
+}
+
+void
+slewReset(ControlHandle handle)
+{
+    Slew * slew = handle;
+    slew->lastAction = 0.0f;
+}
+
+float
+slewUpdate(ControlHandle handle, ControlSystem * system)
+{
+    Slew * slew = handle;
+    float maxChange = slew->rate * system->dt;
+    float change = system->action - slew->lastAction;
+    if (change > maxChange) change = maxChange;
+    else if (change < -maxChange) change = -maxChange;
+    system->action = slew->lastAction + change;
+    slew->lastAction = system->action;
+    return system->action;
+}
+
+void
+slewSetup(ControlHandle handle, Portal * portal)
+{
+    Slew * slew = handle;
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "slew-rate",
+            .handler = portalFloatHandler,
+            .handle = &slew->rate
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+}
+
+// }}}
+
+
+// Clamp Stage {{{
+
+typedef struct
+Clamp
+{
+    float limit;
+    float deadband;
+}
+Clamp;
+
+ControlHandle
+clampInit(float limit, float deadband)
+{
+    Clamp * clamp = malloc(sizeof(Clamp));
+    clamp->limit = limit;
+    clamp->deadband = deadband;
+    return clamp;
+}
+
+float
+clampUpdate(ControlHandle handle, ControlSystem * system)
+{
+    Clamp * clamp = handle;
+    if (system->action > clamp->limit)
+    {
+        system->action = clamp->limit;
+    }
+    else if (system->action < -clamp->limit)
+    {
+        system->action = -clamp->limit;
+    }
+    else if (isWithin(system->action, clamp->deadband))
+    {
+        system->action = 0.0f;
+    }
+    return system->action;
+}
+
+void
+clampSetup(ControlHandle handle, Portal * portal)
+{
+    Clamp * clamp = handle;
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "clamp-limit",
+            .handler = portalFloatHandler,
+            .handle = &clamp->limit
+        },
+        {
+            .key = "clamp-deadband",
+            .handler = portalFloatHandler,
+            .handle = &clamp->deadband
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+}
+
+// }}}
@@ -0,0 +1,308 @@
+#include "events.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "monitor.h"
+
+
+#define QUEUESIZE EVENTS_QUEUESIZE
+#define MAXTYPES EVENTS_MAXTYPES
+#define MAXWAITERS EVENTS_MAXWAITERS
+#define UNUSED(x) (void)(x)
+
+
+// Structs {{{
+
+struct HandlerList;
+typedef struct HandlerList HandlerList;
+
+struct HandlerList
+{
+    EventHandler handler;
+    void * handle;
+    HandlerList * next;
+};
+
+// Each waiter takes a slot with its own semaphore, so a broadcast gives
+// every waiter a wake of its own that no other waiter can take.
+struct Signal
+{
+    Mutex mutex;
+    volatile unsigned long generation;
+    Semaphore wakes[MAXWAITERS];
+    bool waiting[MAXWAITERS];
+};
+
+struct EventQueue
+{
+    // Ring buffer: producers own head (under the mutex), the dispatcher
+    // task owns tail.
+    Event events[QUEUESIZE];
+    volatile unsigned int head;
+    volatile unsigned int tail;
+    unsigned long dropped;
+
+    Event last[MAXTYPES];
+    HandlerList * handlers[MAXTYPES];
+
+    Mutex mutex;
+    Semaphore pending;
+    TaskHandle task;
+};
+
+// }}}
+
+
+
+// Private functions - forward declarations {{{
+
+static void task(void * queuePointer);
+static void callHandlers(HandlerList*, Event);
+static int claimWaiter(Signal*);
+static bool pollSignal(Signal*, unsigned long generation, unsigned long start, unsigned long blockTime);
+static bool remainingTime(unsigned long start, unsigned long blockTime, unsigned long * remaining);
+
+// }}}
+
+
+
+// Public signal methods {{{
+
+Signal *
+signalInit()
+{
+    Signal * signal = malloc(sizeof(Signal));
+    signal->mutex = mutexCreate();
+    signal->generation = 0;
+    for (int i = 0; i < MAXWAITERS; i++)
+    {
+        signal->wakes[i] = semaphoreCreate();
+        signal->waiting[i] = false;
+    }
+    return signal;
+}
+
+unsigned long
+signalGeneration(Signal * signal)
+{
+    return signal->generation;
+}
+
+void
+signalBroadcast(Signal * signal)
+{
+    mutexTake(signal->mutex, -1);
+    signal->generation++;
+    for (int i = 0; i < MAXWAITERS; i++)
+    {
+        if (signal->waiting[i]) semaphoreGive(signal->wakes[i]);
+    }
+    mutexGive(signal->mutex);
+}
+
+// The generation is checked under the same lock a broadcast takes, so a
+// waiter is either woken by a broadcast or sees it.
+bool
+signalWait(Signal * signal, unsigned long generation, const unsigned long blockTime)
+{
+    unsigned long start = millis();
+
+    mutexTake(signal->mutex, -1);
+    if (signal->generation != generation)
+    {
+        mutexGive(signal->mutex);
+        return true;
+    }
+    int slot = claimWaiter(signal);
+    mutexGive(signal->mutex);
+    if (slot < 0) return pollSignal(signal, generation, start, blockTime);
+
+    unsigned long remaining;
+    while (signal->generation == generation)
+    {
+        if (!remainingTime(start, blockTime, &remaining)) break;
+        semaphoreTake(signal->wakes[slot], remaining);
+    }
+
+    mutexTake(signal->mutex, -1);
+    signal->waiting[slot] = false;
+    bool woken = signal->generation != generation;
+    mutexGive(signal->mutex);
+    return woken;
+}
+
+// }}}
+
+
+
+// Public event queue methods {{{
+
+EventQueue *
+eventQueueInit(unsigned int priority)
+{
+    EventQueue * queue = malloc(sizeof(EventQueue));
+    queue->head = 0;
+    queue->tail = 0;
+    queue->dropped = 0;
+    for (int i = 0; i < MAXTYPES; i++)
+    {
+        queue->last[i].type = i;
+        queue->last[i].microTime = 0;
+        queue->handlers[i] = NULL;
+    }
+    queue->mutex = mutexCreate();
+    queue->pending = semaphoreCreate();
+    queue->task = taskCreate(
+        task,
+        TASK_DEFAULT_STACK_SIZE,
+        queue,
+        priority
+    );
+    return queue;
+}
+
+void
+eventQueueOn(EventQueue * queue, unsigned int type, EventHandler handler, void * handle)
+{
+    if (type >= MAXTYPES) return;
+    if (handler == NULL) return;
+
+    HandlerList * item = malloc(sizeof(HandlerList));
+    item->handler = handler;
+    item->handle = handle;
+    item->next = NULL;
+
+    HandlerList ** destination = &queue->handlers[type];
+    while (*destination != NULL)
+    {
+        destination = &(*destination)->next;
+    }
+    *destination = item;
+}
+
+void
+eventQueuePush(EventQueue * queue, unsigned int type)
+{
+    if (type >= MAXTYPES) return;
+
+    Event event =
+    {
+        .type = type,
+        .microTime = micros()
+    };
+
+    mutexTake(queue->mutex, -1);
+    queue->last[type] = event;
+    unsigned int next = (queue->head + 1) % QUEUESIZE;
+    if (next == queue->tail)
+    {
+        // Full: the dispatcher is behind, keep what it has not seen yet.
+        queue->dropped++;
+    }
+    else
+    {
+        queue->events[queue->head] = event;
+        queue->head = next;
+    }
+    mutexGive(queue->mutex);
+
+    semaphoreGive(queue->pending);
+}
+
+Event
+eventQueueLast(EventQueue * queue, unsigned int type)
+{
+    if (type >= MAXTYPES) type = 0;
+    mutexTake(queue->mutex, -1);
+    Event event = queue->last[type];
+    mutexGive(queue->mutex);
+    return event;
+}
+
+unsigned long
+eventQueueDropped(EventQueue * queue)
+{
+    return queue->dropped;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+task(void * queuePointer)
+{
+    EventQueue * queue = queuePointer;
+    int slot = monitorRegister("events");
+    while (true)
+    {
+        semaphoreTake(queue->pending, -1);
+        monitorBegin(slot);
+        while (queue->tail != queue->head)
+        {
+            Event event = queue->events[queue->tail];
+            queue->tail = (queue->tail + 1) % QUEUESIZE;
+            callHandlers(queue->handlers[event.type], event);
+        }
+        monitorEnd(slot);
+    }
+}
+
+static void
+callHandlers(HandlerList * list, Event event)
+{
+    while (list != NULL)
+    {
+        list->handler(list->handle, event);
+        list = list->next;
+    }
+}
+
+// Takes a free waiter slot, clearing any wake a broadcast left in it
+// after its last waiter had already seen the new generation. Called with
+// the signal's mutex held; -1 if every slot is taken.
+static int
+claimWaiter(Signal * signal)
+{
+    for (int i = 0; i < MAXWAITERS; i++)
+    {
+        if (signal->waiting[i]) continue;
+        signal->waiting[i] = true;
+        semaphoreTake(signal->wakes[i], 0);
+        return i;
+    }
+    return -1;
+}
+
+// Waiters beyond the slots check the generation every millisecond.
+static bool
+pollSignal(Signal * signal, unsigned long generation, unsigned long start, unsigned long blockTime)
+{
+    unsigned long remaining;
+    while (signal->generation == generation)
+    {
+        if (!remainingTime(start, blockTime, &remaining)) return false;
+        delay(1);
+    }
+    return true;
+}
+
+// False once blockTime has passed since start; a blockTime of -1 never
+// passes.
+static bool
+remainingTime(unsigned long start, unsigned long blockTime, unsigned long * remaining)
+{
+    *remaining = blockTime;
+    if (blockTime == (unsigned long)-1) return true;
+    unsigned long elapsed = millis() - start;
+    if (elapsed >= blockTime) return false;
+    *remaining = blockTime - elapsed;
+    return true;
+}
+
+// }}}
@@ -3,36 +3,66 @@
 #include <API.h>
 #include <string.h>
 #include <stdbool.h>
+#include <math.h>
 #include "pigeon.h"
 #include "control.h"
+#include "pipeline.h"
+#include "events.h"
+#include "barrier.h"
+#include "latency.h"
+#include "monitor.h"
 #include "utils.h"
 #include "shims.h"
 
 
 #define UNUSED(x) (void)(x)
+#define LINESIZE PIGEON_LINESIZE
+// Seconds the time constant fit averages over, and the range it is held to
+#define ETA_SMOOTHING 1.0f
+#define ETA_MINTAU 0.05f
+#define ETA_MAXTAU 30.0f
 
 
 // Typedefs {{{
 
+typedef enum
+FlywheelLatency
+{
+    LATENCY_WAIT,
+    LATENCY_SENSE,
+    LATENCY_CONTROL,
+    LATENCY_ACTUATE,
+    LATENCY_FLUSH,
+    LATENCY_LOOP,
+    LATENCY_NUMOFSTAGES
+}
+FlywheelLatency;
+
 struct Flywheel
 {
+    const char * id;
     Portal * portal;
 
+    // system.target is the setpoint, which follows the goal along the
+    // profile.
     ControlSystem system;
-    ControlUpdater controlUpdate;
-    ControlResetter controlReset;
-    ControlHandle control;
+    Pipeline * pipeline;
+
+    float goal;
+    float setpointRate;
+    float profileRate;
+    float profileJerk;
 
     float measuredRaw;
 
     float gearing;
-    float smoothing;
     EncoderGetter encoderGet;
     EncoderResetter encoderReset;
     EncoderHandle encoder;
 
     MotorSetter motorSet[8];
     MotorHandle motors[8];
+    MotorWriteGetter motorWriteGet;
 
     bool ready;
     unsigned int priorityReady;
@@ -43,13 +73,29 @@ struct Flywheel
     float thresholdError;
     float thresholdDerivative;
     int checkCycle;
+    int readyFrames;
 
-    Semaphore readySemaphore;
+    // First-order fit of the approach to the goal, seconds; 0 until fitted
+    float timeConstant;
+    float eta;
+
+    EventQueue * events;
+    Signal * readySignal;
+    int barrier;
     FlywheelHandler onready;
     void * onreadyHandle;
     FlywheelHandler onactive;
     void * onactiveHandle;
 
+    LatencyHistogram latency[LATENCY_NUMOFSTAGES];
+    FlywheelLatency latencySelected;
+    // When this frame's encoder count was read, and when the last frame
+    // posted its command and from which count, until its write is seen.
+    unsigned long sampleTime;
+    unsigned long postTime;
+    unsigned long postSampleTime;
+    bool postPending;
+
     Mutex mutex;
     TaskHandle task;
 };
@@ -64,15 +110,24 @@ struct Flywheel
 static void task(void * flywheelPointer);
 static void update(Flywheel*);
 static void updateSystem(Flywheel*);
+static void updateSetpoint(Flywheel*);
 static void updateControl(Flywheel*);
 static void updateMotor(Flywheel*);
+static void recordWrite(Flywheel*, unsigned long now);
 static void checkReady(Flywheel*);
+static void updateFrameDelay(Flywheel*);
+static void updateEta(Flywheel*);
 static void activate(Flywheel*);
 static void readify(Flywheel*);
 static void setupPortal(Flywheel*, FlywheelSetup);
 static void readyHandler(void * handle, char * message, char * response);
-
-static void printDebugInfo(Flywheel*);
+static void readyTimeHandler(void * handle, char * message, char * response);
+static void activeTimeHandler(void * handle, char * message, char * response);
+static void latencyHandler(void * handle, char * message, char * response);
+static void latencyRawHandler(void * handle, char * message, char * response);
+static void selectLatency(Flywheel*, char * message);
+static void dispatchReady(void * flywheelPointer, Event);
+static void dispatchActive(void * flywheelPointer, Event);
 
 // }}}
 
@@ -85,24 +140,29 @@ Flywheel *
 flywheelInit(FlywheelSetup setup)
 {
     Flywheel * flywheel = malloc(sizeof(Flywheel));
+    flywheel->id = setup.id;
 
     setupPortal(flywheel, setup);
 
     flywheel->system.microTime = micros();
     flywheel->system.dt = 0.0f;
     flywheel->system.target = 0.0f;
+    flywheel->system.goal = 0.0f;
     flywheel->system.measured = 0.0f;
     flywheel->system.derivative = 0.0f;
     flywheel->system.error = 0.0f;
     flywheel->system.action = 0.0f;
 
-    flywheel->controlUpdate = setup.controlUpdater;
-    flywheel->controlReset = setup.controlResetter;
-    flywheel->control = setup.control;
-    setup.controlSetup(setup.control, flywheel->portal);
+    flywheel->pipeline = pipelineInit(flywheel->portal);
+    pipelineAddBatch(flywheel->pipeline, setup.stages);
 
+    flywheel->goal = 0.0f;
+    flywheel->setpointRate = 0.0f;
+    flywheel->profileRate = setup.profileRate;
+    flywheel->profileJerk = setup.profileJerk;
+
+    flywheel->measuredRaw = 0.0f;
     flywheel->gearing = setup.gearing;
-    flywheel->smoothing = setup.smoothing;
     flywheel->encoderGet = setup.encoderGetter;
     flywheel->encoderReset = setup.encoderResetter;
     flywheel->encoder = setup.encoder;
@@ -112,6 +172,7 @@ flywheelInit(FlywheelSetup setup)
         flywheel->motorSet[i] = setup.motorSetters[i];
         flywheel->motors[i] = setup.motors[i];
     }
+    flywheel->motorWriteGet = setup.motorWriteGetter;
 
     flywheel->ready = true;
     flywheel->priorityReady = setup.priorityReady;
@@ -125,12 +186,33 @@ flywheelInit(FlywheelSetup setup)
     flywheel->thresholdDerivative = setup.thresholdDerivative;
 
     flywheel->checkCycle = setup.checkCycle;
+    flywheel->readyFrames = setup.checkCycle;
+
+    flywheel->timeConstant = 0.0f;
+    flywheel->eta = 0.0f;
 
-    flywheel->readySemaphore = semaphoreCreate();
+    flywheel->events = eventQueueInit(setup.priorityEvents);
+    flywheel->readySignal = signalInit();
+    flywheel->barrier = barrierRegister(setup.id);
+    barrierSet(flywheel->barrier, flywheel->ready);
     flywheel->onready = setup.onready;
     flywheel->onreadyHandle = setup.onreadyHandle;
     flywheel->onactive = setup.onactive;
     flywheel->onactiveHandle = setup.onactiveHandle;
+    flywheelOn(flywheel, FLYWHEEL_EVENT_READY, dispatchReady, flywheel);
+    flywheelOn(flywheel, FLYWHEEL_EVENT_ACTIVE, dispatchActive, flywheel);
+
+    latencyInit(&flywheel->latency[LATENCY_WAIT], "wait");
+    latencyInit(&flywheel->latency[LATENCY_SENSE], "sense");
+    latencyInit(&flywheel->latency[LATENCY_CONTROL], "control");
+    latencyInit(&flywheel->latency[LATENCY_ACTUATE], "actuate");
+    latencyInit(&flywheel->latency[LATENCY_FLUSH], "flush");
+    latencyInit(&flywheel->latency[LATENCY_LOOP], "loop");
+    flywheel->latencySelected = LATENCY_LOOP;
+    flywheel->sampleTime = 0;
+    flywheel->postTime = 0;
+    flywheel->postSampleTime = 0;
+    flywheel->postPending = false;
 
     flywheel->mutex = mutexCreate();
     flywheel->task = NULL;
@@ -149,13 +231,19 @@ flywheelReset(Flywheel * flywheel)
     flywheel->system.derivative = 0.0f;
     flywheel->system.error = 0.0f;
     flywheel->system.action = 0.0f;
+    flywheel->measuredRaw = 0.0f;
+
+    // The setpoint starts again from rest.
+    flywheel->system.target = 0.0f;
+    flywheel->setpointRate = 0.0f;
 
+    portalUpdate(flywheel->portal, "setpoint");
     portalUpdate(flywheel->portal, "measured");
     portalUpdate(flywheel->portal, "derivative");
     portalUpdate(flywheel->portal, "error");
     portalUpdate(flywheel->portal, "action");
 
-    flywheel->controlReset(flywheel->control);
+    pipelineReset(flywheel->pipeline);
     flywheel->encoderReset(flywheel->encoder);
 }
 
@@ -164,7 +252,7 @@ void
 flywheelSet(Flywheel * flywheel, float rpm)
 {
     mutexTake(flywheel->mutex, -1);
-    flywheel->system.target = rpm;
+    flywheel->goal = rpm;
     mutexGive(flywheel->mutex);
 
     portalUpdate(flywheel->portal, "target");
@@ -191,10 +279,28 @@ flywheelRun(Flywheel * flywheel)
 }
 
 void
+flywheelOn(
+    Flywheel * flywheel,
+    FlywheelEvent event,
+    EventHandler handler,
+    void * handle
+){
+    eventQueueOn(flywheel->events, event, handler, handle);
+}
+
+float
+flywheelGetEta(Flywheel * flywheel)
+{
+    return flywheel->eta;
+}
+
+// Returns false on timeout
+bool
 waitUntilFlywheelReady(Flywheel * flywheel, const unsigned long blockTime)
 {
-    if (flywheel->ready) return;
-    semaphoreTake(flywheel->readySemaphore, blockTime);
+    unsigned long generation = signalGeneration(flywheel->readySignal);
+    if (flywheel->ready) return true;
+    return signalWait(flywheel->readySignal, generation, blockTime);
 }
 
 // }}}
@@ -208,42 +314,91 @@ static void
 task(void * flywheelPointer)
 {
     Flywheel * flywheel = flywheelPointer;
-    int i = 0;
+    int slot = monitorRegister(flywheel->id);
+    unsigned long wakeTime = millis();
     while (true)
     {
-        i = flywheel->checkCycle;
-        while (i)
-        {
-            update(flywheel);
-            //printDebugInfo(flywheel);
-            delay(flywheel->frameDelay);
-            --i;
-        }
+        monitorBegin(slot);
+        update(flywheel);
         checkReady(flywheel);
+        updateFrameDelay(flywheel);
+        updateEta(flywheel);
+        monitorEnd(slot);
+        taskDelayUntil(&wakeTime, flywheel->frameDelay);
     }
 }
 
 
-// Temporary debugging measures:
-// (Should be replaced with pigeon once pigeon is stabalized)
-static void
-printDebugInfo(Flywheel * flywheel)
-{
-    printf("flywheel rpm: %f\n", flywheel->system.measured);
-    printf("flywheel action: %f\n", flywheel->system.action);
-    printf("flywheel raw: %f\n", flywheel->measuredRaw);
-}
-
-
 static void
 update(Flywheel * flywheel)
 {
+    unsigned long times[LATENCY_NUMOFSTAGES];
+
+    times[LATENCY_WAIT] = micros();
     mutexTake(flywheel->mutex, -1);
+    times[LATENCY_SENSE] = micros();
+    recordWrite(flywheel, times[LATENCY_SENSE]);
     updateSystem(flywheel);
+    times[LATENCY_CONTROL] = micros();
     updateControl(flywheel);
+    times[LATENCY_ACTUATE] = micros();
     updateMotor(flywheel);
+    times[LATENCY_FLUSH] = micros();
     portalFlush(flywheel->portal);
+    times[LATENCY_LOOP] = micros();
     mutexGive(flywheel->mutex);
+
+    // Each stage runs from its own timestamp to the next one's, but for
+    // posted commands, which are timed once they are written.
+    bool posted = flywheel->motorWriteGet != NULL;
+    LatencyHistogram * latency = flywheel->latency;
+    for (int i = LATENCY_WAIT; i < LATENCY_LOOP; i++)
+    {
+        if (i == LATENCY_ACTUATE && posted) continue;
+        latencyRecord(&latency[i], times[i + 1] - times[i]);
+    }
+
+    if (posted)
+    {
+        flywheel->postTime = times[LATENCY_ACTUATE];
+        flywheel->postSampleTime = flywheel->sampleTime;
+        flywheel->postPending = true;
+    }
+    else
+    {
+        // Encoder read to actuator
+        latencyRecord(
+            &latency[LATENCY_LOOP],
+            times[LATENCY_FLUSH] - flywheel->sampleTime
+        );
+    }
+}
+
+
+// Times the last frame's post to its write: actuate from the post, loop
+// from the encoder read it was computed from. One the writer has not yet
+// taken up is counted as written now, as this frame's post replaces it.
+static void
+recordWrite(Flywheel * flywheel, unsigned long now)
+{
+    if (!flywheel->postPending) return;
+    flywheel->postPending = false;
+
+    unsigned long writeTime = now;
+    MotorsWrite write;
+    bool written =
+        flywheel->motorWriteGet(flywheel->motors[0], &write) &&
+        (long)(write.postTime - flywheel->postTime) >= 0;
+    if (written) writeTime = write.writeTime;
+
+    latencyRecord(
+        &flywheel->latency[LATENCY_ACTUATE],
+        writeTime - flywheel->postTime
+    );
+    latencyRecord(
+        &flywheel->latency[LATENCY_LOOP],
+        writeTime - flywheel->postSampleTime
+    );
 }
 
 
@@ -254,46 +409,83 @@ updateSystem(Flywheel * flywheel)
     flywheel->system.dt = dt;
 
     // Raw rpm
-    float rpm = flywheel->encoderGet(flywheel->encoder).rpm;
-    rpm *= flywheel->gearing;
+    EncoderReading reading = flywheel->encoderGet(flywheel->encoder);
+    float rpm = reading.rpm * flywheel->gearing;
+    flywheel->sampleTime = reading.microTime;
 
-    // Low-pass filter
-    float measureChange = (rpm - flywheel->system.measured);
-    measureChange *= dt / flywheel->smoothing;
-    float derivative = measureChange / dt;
-    float derivativeChange = (derivative - flywheel->system.derivative);
-    derivativeChange *= dt / flywheel->smoothing;
+    // Unfiltered; any smoothing is left to the pipeline's input stages.
+    float derivative = 0.0f;
+    if (dt > 0.0f) derivative = (rpm - flywheel->measuredRaw) / dt;
 
-    // Update
     flywheel->measuredRaw = rpm;
-    flywheel->system.measured += measureChange;
-    flywheel->system.derivative += derivativeChange;
+    flywheel->system.measured = rpm;
+    flywheel->system.derivative = derivative;
 
-    // Calculate error
-    float error = flywheel->system.measured - flywheel->system.target;
-    flywheel->system.error = error;
+    updateSetpoint(flywheel);
+    flywheel->system.error = rpm - flywheel->system.target;
 
     portalUpdate(flywheel->portal, "dt");
     portalUpdate(flywheel->portal, "raw");
-    portalUpdate(flywheel->portal, "measured");
-    portalUpdate(flywheel->portal, "derivative");
-    portalUpdate(flywheel->portal, "error");
 }
 
 
+// Moves the setpoint toward the goal at up to profileRate rpm/s, that rate
+// changing by up to profileJerk rpm/s^2 and easing off in time to land on
+// the goal: an S-curve. Without a rate limit the setpoint jumps, and
+// without a jerk limit it ramps.
 static void
-updateControl(Flywheel * flywheel)
+updateSetpoint(Flywheel * flywheel)
 {
-    flywheel->controlUpdate(flywheel->control, &flywheel->system);
+    ControlSystem * system = &flywheel->system;
+    system->goal = flywheel->goal;
+    float remaining = system->goal - system->target;
+    float dt = system->dt;
+    float rateLimit = flywheel->profileRate;
+    float jerk = flywheel->profileJerk;
+
+    // As fast as lands on the goal this frame, or can still brake to it
+    float rate = dt > 0.0f? remaining / dt : 0.0f;
+    if (jerk > 0.0f)
+    {
+        float braking = sqrtf(2.0f * jerk * fabsf(remaining));
+        if (braking < fabsf(rate)) rate = remaining > 0.0f? braking : -braking;
 
-    if (flywheel->system.action > 127)
+        float changeLimit = jerk * dt;
+        float change = rate - flywheel->setpointRate;
+        if (change > changeLimit) rate = flywheel->setpointRate + changeLimit;
+        else if (change < -changeLimit) rate = flywheel->setpointRate - changeLimit;
+    }
+    if (rate > rateLimit) rate = rateLimit;
+    else if (rate < -rateLimit) rate = -rateLimit;
+
+    // Stop on the goal rather than pass it.
+    float step = rate * dt;
+    bool arrived =
+        rateLimit <= 0.0f ||
+        (remaining >= 0.0f && step >= remaining) ||
+        (remaining <= 0.0f && step <= remaining);
+    if (arrived)
     {
-        flywheel->system.action = 127;
+        system->target = flywheel->goal;
+        flywheel->setpointRate = 0.0f;
     }
-    if (flywheel->system.action < -127)
+    else
     {
-        flywheel->system.action = -127;
+        system->target += step;
+        flywheel->setpointRate = rate;
     }
+    portalUpdate(flywheel->portal, "setpoint");
+}
+
+
+static void
+updateControl(Flywheel * flywheel)
+{
+    pipelineUpdate(flywheel->pipeline, &flywheel->system);
+
+    portalUpdate(flywheel->portal, "measured");
+    portalUpdate(flywheel->portal, "derivative");
+    portalUpdate(flywheel->portal, "error");
     portalUpdate(flywheel->portal, "action");
 }
 
@@ -310,14 +502,27 @@ updateMotor(Flywheel * flywheel)
 }
 
 
+// Judged against the goal, so never ready partway along the profile.
 static void
 checkReady(Flywheel * flywheel)
 {
     bool errorReady =
-        isWithin(flywheel->system.error, flywheel->thresholdError);
+        flywheel->system.target == flywheel->goal &&
+        isWithin(flywheel->system.measured - flywheel->goal, flywheel->thresholdError);
     bool derivativeReady =
         isWithin(flywheel->system.derivative, flywheel->thresholdDerivative);
-    bool ready = errorReady && derivativeReady;
+
+    // Leave ready as soon as a frame is out of the thresholds, but only
+    // become ready after checkCycle frames in a row within them.
+    if (errorReady && derivativeReady)
+    {
+        if (flywheel->readyFrames < flywheel->checkCycle) flywheel->readyFrames++;
+    }
+    else
+    {
+        flywheel->readyFrames = 0;
+    }
+    bool ready = flywheel->readyFrames >= flywheel->checkCycle;
 
     if (ready && !flywheel->ready)
     {
@@ -330,10 +535,110 @@ checkReady(Flywheel * flywheel)
 }
 
 
+// The further outside the ready thresholds, the closer the frame delay
+// gets to frameDelayActive; right on target it is frameDelayReady.
+// Thresholds of zero leave no room to be inside them, so the delay stays
+// at frameDelayActive.
+static void
+updateFrameDelay(Flywheel * flywheel)
+{
+    unsigned long frameDelay = flywheel->frameDelayActive;
+    if (flywheel->thresholdError > 0.0f && flywheel->thresholdDerivative > 0.0f)
+    {
+        float errorRatio =
+            (flywheel->system.measured - flywheel->goal) / flywheel->thresholdError;
+        float derivativeRatio =
+            flywheel->system.derivative / flywheel->thresholdDerivative;
+        float activity =
+            errorRatio * errorRatio + derivativeRatio * derivativeRatio;
+
+        float range = (float)flywheel->frameDelayReady - flywheel->frameDelayActive;
+        frameDelay = flywheel->frameDelayActive + range / (1.0f + activity);
+    }
+    bool settling = !flywheel->ready && flywheel->checkCycle > 0;
+    if (settling && frameDelay > flywheel->frameDelayActive)
+    {
+        // Still settling: keep the active rate until proven ready.
+        float settled = (float)flywheel->readyFrames / flywheel->checkCycle;
+        frameDelay = flywheel->frameDelayActive + settled * (frameDelay - flywheel->frameDelayActive);
+    }
+
+    if (frameDelay != flywheel->frameDelay)
+    {
+        flywheel->frameDelay = frameDelay;
+        portalUpdate(flywheel->portal, "delay");
+    }
+}
+
+
+// Fits the approach to the goal as first order, error' = -error / tau,
+// from frames heading toward it while still well outside the thresholds.
+// The estimate is then the time for the error to decay to within them,
+// the setpoint's ramp at the least, plus the frames left to prove ready.
+static void
+updateEta(Flywheel * flywheel)
+{
+    ControlSystem * system = &flywheel->system;
+    float error = system->measured - flywheel->goal;
+    float derivative = system->derivative;
+    float dt = system->dt;
+
+    bool approaching = error * derivative < 0.0f;
+    if (approaching && fabsf(error) > 2.0f * flywheel->thresholdError && dt > 0.0f)
+    {
+        float tau = -error / derivative;
+        if (tau < ETA_MINTAU) tau = ETA_MINTAU;
+        if (tau > ETA_MAXTAU) tau = ETA_MAXTAU;
+        if (flywheel->timeConstant <= 0.0f) flywheel->timeConstant = tau;
+        float weight = dt < ETA_SMOOTHING? dt / ETA_SMOOTHING : 1.0f;
+        flywheel->timeConstant += (tau - flywheel->timeConstant) * weight;
+    }
+
+    float eta = 0.0f;
+    if (!flywheel->ready)
+    {
+        float tau = flywheel->timeConstant;
+
+        // Within the derivative threshold too, which the decay has by
+        // |error| < thresholdDerivative * tau.
+        float threshold = flywheel->thresholdError;
+        if (tau > 0.0f && flywheel->thresholdDerivative * tau < threshold)
+        {
+            threshold = flywheel->thresholdDerivative * tau;
+        }
+
+        if (threshold <= 0.0f)
+        {
+            // Never reached by a decay
+            eta = -1.0f;
+        }
+        else if (fabsf(error) >= threshold)
+        {
+            // Unknown until there is a fit
+            eta = tau > 0.0f? tau * logf(fabsf(error) / threshold) : -1.0f;
+        }
+        if (eta >= 0.0f && flywheel->profileRate > 0.0f)
+        {
+            float ramp = fabsf(flywheel->goal - system->target) / flywheel->profileRate;
+            if (ramp > eta) eta = ramp;
+        }
+        if (eta >= 0.0f)
+        {
+            int framesLeft = flywheel->checkCycle - flywheel->readyFrames;
+            if (framesLeft > 0) eta += framesLeft * flywheel->frameDelayActive / 1000.0f;
+        }
+    }
+
+    flywheel->eta = eta;
+    portalUpdate(flywheel->portal, "eta");
+}
+
+
 static void
 activate(Flywheel * flywheel)
 {
     flywheel->ready = false;
+    flywheel->readyFrames = 0;
     flywheel->frameDelay = flywheel->frameDelayActive;
     if (flywheel->task)
     {
@@ -341,13 +646,10 @@ activate(Flywheel * flywheel)
     }
     portalUpdate(flywheel->portal, "ready");
     portalUpdate(flywheel->portal, "delay");
+    barrierSet(flywheel->barrier, false);
 
-    if (flywheel->onactive != NULL)
-    {
-        flywheel->onactive(flywheel->onactiveHandle);
-    }
-
-    // TODO: Signal not ready?
+    eventQueuePush(flywheel->events, FLYWHEEL_EVENT_ACTIVE);
+    portalUpdate(flywheel->portal, "active-time");
 }
 
 
@@ -355,20 +657,41 @@ static void
 readify(Flywheel * flywheel)
 {
     flywheel->ready = true;
-    flywheel->frameDelay = flywheel->frameDelayReady;
+    flywheel->readyFrames = flywheel->checkCycle;
     if (flywheel->task)
     {
         taskPrioritySet(flywheel->task, flywheel->priorityReady);
     }
     portalUpdate(flywheel->portal, "ready");
-    portalUpdate(flywheel->portal, "delay");
 
+    eventQueuePush(flywheel->events, FLYWHEEL_EVENT_READY);
+    signalBroadcast(flywheel->readySignal);
+    barrierSet(flywheel->barrier, true);
+    portalUpdate(flywheel->portal, "ready-time");
+}
+
+
+static void
+dispatchReady(void * flywheelPointer, Event event)
+{
+    UNUSED(event);
+    Flywheel * flywheel = flywheelPointer;
     if (flywheel->onready != NULL)
     {
         flywheel->onready(flywheel->onreadyHandle);
     }
+}
+
 
-    semaphoreGive(flywheel->readySemaphore);
+static void
+dispatchActive(void * flywheelPointer, Event event)
+{
+    UNUSED(event);
+    Flywheel * flywheel = flywheelPointer;
+    if (flywheel->onactive != NULL)
+    {
+        flywheel->onactive(flywheel->onactiveHandle);
+    }
 }
 
 
@@ -398,10 +721,26 @@ setupPortal(Flywheel * flywheel, FlywheelSetup setup)
         {
             .key = "target",
             .handler = portalFloatHandler,
-            .handle = &flywheel->system.target,
+            .handle = &flywheel->goal,
             .stream = true,
             .onchange = true
         },
+        {
+            .key = "setpoint",
+            .handler = portalFloatHandler,
+            .handle = &flywheel->system.target,
+            .stream = true
+        },
+        {
+            .key = "profile-rate",
+            .handler = portalFloatHandler,
+            .handle = &flywheel->profileRate
+        },
+        {
+            .key = "profile-jerk",
+            .handler = portalFloatHandler,
+            .handle = &flywheel->profileJerk
+        },
         {
             .key = "measured",
             .handler = portalFloatHandler,
@@ -435,17 +774,34 @@ setupPortal(Flywheel * flywheel, FlywheelSetup setup)
             .handler = portalFloatHandler,
             .handle = &flywheel->gearing
         },
-        {
-            .key = "smoothing",
-            .handler = portalFloatHandler,
-            .handle = &flywheel->smoothing
-        },
         {
             .key = "ready",
             .handler = readyHandler,
             .handle = flywheel,
             .onchange = true
         },
+        {
+            .key = "ready-time",
+            .handler = readyTimeHandler,
+            .handle = flywheel,
+            .onchange = true
+        },
+        {
+            .key = "active-time",
+            .handler = activeTimeHandler,
+            .handle = flywheel,
+            .onchange = true
+        },
+        {
+            .key = "latency",
+            .handler = latencyHandler,
+            .handle = flywheel
+        },
+        {
+            .key = "latency-raw",
+            .handler = latencyRawHandler,
+            .handle = flywheel
+        },
         {
             .key = "priority-ready",
             .handler = portalUintHandler,
@@ -458,18 +814,18 @@ setupPortal(Flywheel * flywheel, FlywheelSetup setup)
         },
         {
             .key = "delay",
-            .handler = portalUlongHandler,
+            .handler = portalPeriodHandler,
             .handle = &flywheel->frameDelay,
             .onchange = true
         },
         {
             .key = "delay-ready",
-            .handler = portalUlongHandler,
+            .handler = portalPeriodHandler,
             .handle = &flywheel->frameDelayReady
         },
         {
             .key = "delay-active",
-            .handler = portalUlongHandler,
+            .handler = portalPeriodHandler,
             .handle = &flywheel->frameDelayActive
         },
         {
@@ -482,6 +838,17 @@ setupPortal(Flywheel * flywheel, FlywheelSetup setup)
             .handler = portalFloatHandler,
             .handle = &flywheel->thresholdDerivative
         },
+        {
+            .key = "eta",
+            .handler = portalFloatHandler,
+            .handle = &flywheel->eta,
+            .stream = true
+        },
+        {
+            .key = "time-constant",
+            .handler = portalFloatHandler,
+            .handle = &flywheel->timeConstant
+        },
         {
             .key = "check-cycle",
             .handler = portalIntHandler,
@@ -517,4 +884,70 @@ readyHandler(void * handle, char * message, char * response)
     else if (strcmp(message, "false") == 0) activate(flywheel);
 }
 
+static void
+readyTimeHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    if (message != NULL) return;
+    Flywheel * flywheel = handle;
+    Event event = eventQueueLast(flywheel->events, FLYWHEEL_EVENT_READY);
+    sprintf(response, "%lu", event.microTime);
+}
+
+static void
+activeTimeHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    if (message != NULL) return;
+    Flywheel * flywheel = handle;
+    Event event = eventQueueLast(flywheel->events, FLYWHEEL_EVENT_ACTIVE);
+    sprintf(response, "%lu", event.microTime);
+}
+
+static void
+latencyHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    Flywheel * flywheel = handle;
+    selectLatency(flywheel, message);
+    LatencyHistogram * histogram = &flywheel->latency[flywheel->latencySelected];
+    latencySummary(histogram, response, LINESIZE);
+}
+
+static void
+latencyRawHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    Flywheel * flywheel = handle;
+    selectLatency(flywheel, message);
+    LatencyHistogram * histogram = &flywheel->latency[flywheel->latencySelected];
+    latencyBuckets(histogram, response, LINESIZE);
+}
+
+// Writing a stage name selects it, "reset" clears every histogram.
+static void
+selectLatency(Flywheel * flywheel, char * message)
+{
+    if (message == NULL) return;
+    if (strcmp(message, "reset") == 0)
+    {
+        for (int i = 0; i < LATENCY_NUMOFSTAGES; i++)
+        {
+            latencyReset(&flywheel->latency[i]);
+        }
+        return;
+    }
+    for (int i = 0; i < LATENCY_NUMOFSTAGES; i++)
+    {
+        if (strcmp(message, flywheel->latency[i].name) == 0)
+        {
+            flywheel->latencySelected = i;
+        }
+    }
+}
+
 // }}}
@@ -0,0 +1,278 @@
+#include "imes.h"
+
+#include <API.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "monitor.h"
+#include "pigeon.h"
+
+
+#define MAXDEVICES IMES_MAXDEVICES
+#define ATTEMPTS IMES_ATTEMPTS
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+Device
+{
+    // Both guarded by the mutex; the snapshot is published whole.
+    ImesReading reading;
+    ImesStats stats;
+}
+Device;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void task(void * data);
+static void sweep();
+static void readDevice(unsigned char address);
+static bool attempt(bool (*transaction)(unsigned char, int*), unsigned char address, int * value, unsigned long * retries);
+static void setupPortal(Pigeon*);
+static void deviceHandler(void * handle, char * message, char * response);
+
+static Device devices[MAXDEVICES];
+static unsigned int count = 0;
+static unsigned long sweeps = 0;
+static Mutex mutex = NULL;
+
+static Portal * portal = NULL;
+static TaskHandle sweeper = NULL;
+static unsigned long period = 20;
+
+static char * deviceKeys[MAXDEVICES] =
+{
+    "ime-0",
+    "ime-1",
+    "ime-2",
+    "ime-3",
+    "ime-4",
+    "ime-5",
+    "ime-6",
+    "ime-7"
+};
+
+// }}}
+
+
+
+// Public methods {{{
+
+void
+imesInit(Pigeon * pigeon, unsigned long sweepPeriod, unsigned int priority)
+{
+    if (mutex != NULL) return;
+    mutex = mutexCreate();
+    memset(devices, 0, sizeof(devices));
+    count = imeInitializeAll();
+    if (count > MAXDEVICES) count = MAXDEVICES;
+    // With no chain there is nothing to sweep or report.
+    if (count == 0) return;
+    period = sweepPeriod;
+    setupPortal(pigeon);
+    sweeper = taskCreate(task, TASK_DEFAULT_STACK_SIZE, NULL, priority);
+}
+
+unsigned int
+imesGetCount()
+{
+    return count;
+}
+
+ImesReading
+imesGet(unsigned char address)
+{
+    ImesReading reading = {0};
+    if (address >= count) return reading;
+    mutexTake(mutex, -1);
+    reading = devices[address].reading;
+    mutexGive(mutex);
+    return reading;
+}
+
+ImesStats
+imesGetStats(unsigned char address)
+{
+    ImesStats stats = {0};
+    if (address >= count) return stats;
+    mutexTake(mutex, -1);
+    stats = devices[address].stats;
+    mutexGive(mutex);
+    return stats;
+}
+
+unsigned long
+imesGetSweepCount()
+{
+    return sweeps;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+task(void * data)
+{
+    UNUSED(data);
+    int slot = monitorRegister("imes");
+    unsigned long wakeTime = millis();
+    while (true)
+    {
+        monitorBegin(slot);
+        sweep();
+        portalFlush(portal);
+        monitorEnd(slot);
+        taskDelayUntil(&wakeTime, period);
+    }
+}
+
+static void
+sweep()
+{
+    for (unsigned int address = 0; address < count; address++)
+    {
+        readDevice(address);
+        portalUpdate(portal, deviceKeys[address]);
+    }
+    sweeps++;
+}
+
+// The bus is only touched outside the lock, so readers wait at most for a
+// copy.
+static void
+readDevice(unsigned char address)
+{
+    int angle = 0;
+    int rpm = 0;
+    unsigned long retries = 0;
+    bool success =
+        attempt(imeGet, address, &angle, &retries) &&
+        attempt(imeGetVelocity, address, &rpm, &retries);
+    unsigned long microTime = micros();
+
+    mutexTake(mutex, -1);
+    Device * device = &devices[address];
+    device->stats.reads++;
+    device->stats.retries += retries;
+    if (success)
+    {
+        device->reading.count = angle;
+        device->reading.velocity = rpm;
+        device->reading.microTime = microTime;
+        device->stats.failing = 0;
+    }
+    else
+    {
+        device->stats.errors++;
+        device->stats.failing++;
+    }
+    mutexGive(mutex);
+}
+
+static bool
+attempt(
+    bool (*transaction)(unsigned char, int*),
+    unsigned char address,
+    int * value,
+    unsigned long * retries
+)
+{
+    for (int i = 0; i < ATTEMPTS; i++)
+    {
+        if (i > 0) (*retries)++;
+        if (transaction(address, value)) return true;
+    }
+    return false;
+}
+
+static void
+setupPortal(Pigeon * pigeon)
+{
+    portal = pigeonCreatePortal(pigeon, "imes");
+
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "count",
+            .handler = portalUintHandler,
+            .handle = &count
+        },
+        {
+            .key = "sweeps",
+            .handler = portalUlongHandler,
+            .handle = &sweeps
+        },
+        {
+            .key = "period",
+            .handler = portalPeriodHandler,
+            .handle = &period
+        },
+        {
+            .key = "keys",
+            .handler = portalStreamKeyHandler,
+            .handle = portal
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+
+    for (int i = 0; i < MAXDEVICES; i++)
+    {
+        PortalEntrySetup setup =
+        {
+            .key = deviceKeys[i],
+            .handler = deviceHandler,
+            .handle = &devices[i],
+            .stream = true
+        };
+        portalAdd(portal, setup);
+    }
+
+    portalReady(portal);
+}
+
+// "count=<ticks> rpm=<rpm> retries=<n> errors=<n> failing=<n>"
+static void
+deviceHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    UNUSED(message);
+    Device * device = handle;
+    unsigned char address = device - devices;
+    if (address >= count)
+    {
+        strcpy(response, "none");
+        return;
+    }
+    ImesReading reading = imesGet(address);
+    ImesStats stats = imesGetStats(address);
+    snprintf(
+        response,
+        PIGEON_LINESIZE,
+        "count=%d rpm=%d retries=%lu errors=%lu failing=%lu",
+        reading.count,
+        reading.velocity,
+        stats.retries,
+        stats.errors,
+        stats.failing
+    );
+}
+
+// }}}
@@ -3,6 +3,15 @@
 #include <API.h>
 #include "flywheel.h"
 #include "control.h"
+#include "pipeline.h"
+#include "autotune.h"
+#include "schedule.h"
+#include "battery.h"
+#include "monitor.h"
+#include "barrier.h"
+#include "motors.h"
+#include "imes.h"
+#include "sampler.h"
 #include "shims.h"
 
 #define UNUSED(x) (void)(x)
@@ -35,18 +44,84 @@ void initialize()
 
     pigeon = pigeonInit(pigeonGets, pigeonPuts, millis);
 
+    monitorInit(pigeon, 1000, TASK_PRIORITY_LOWEST + 1);
+    barrierInit(pigeon);
+    batteryInit(pigeon, 7.2f, 1.0f, 50);
+    motorsInit(20, TASK_PRIORITY_DEFAULT + 1);
+    motorsCompensate(1, true);
+    imesInit(pigeon, 20, TASK_PRIORITY_DEFAULT + 1);
+    // Above everything that reads sensors.
+    samplerInit(pigeon, 10, TASK_PRIORITY_DEFAULT + 2);
+
+    ControlHandle flywheelControl = tbhInit(0.2f, 10.0f, flywheelEstimator);
+    ControlHandle flywheelSchedule = scheduleInit(tbhSetGains, flywheelControl);
+
+    PipelineStageSetup flywheelStages[] =
+    {
+        {
+            .key = "filter",
+            .setup = lowPassSetup,
+            .updater = lowPassUpdate,
+            .resetter = lowPassReset,
+            .handle = lowPassInit(0.2f)
+        },
+        {
+            .key = "schedule",
+            .setup = scheduleSetup,
+            .updater = scheduleUpdate,
+            .resetter = scheduleReset,
+            .handle = flywheelSchedule
+        },
+        {
+            .key = "control",
+            .setup = feedforwardSetup,
+            .updater = feedforwardUpdate,
+            .resetter = feedforwardReset,
+            .handle = feedforwardInit(
+                flywheelEstimator,
+                tbhSetup,
+                tbhUpdate,
+                tbhReset,
+                flywheelControl
+            )
+        },
+        {
+            .key = "autotune",
+            .setup = autotuneSetup,
+            .updater = autotuneUpdate,
+            .resetter = autotuneReset,
+            .handle = autotuneInit(scheduleSetGains, flywheelSchedule, 20.0f, 15.0f)
+        },
+        {
+            .key = "slew",
+            .setup = slewSetup,
+            .updater = slewUpdate,
+            .resetter = slewReset,
+            .handle = slewInit(2540.0f)
+        },
+        {
+            .key = "clamp",
+            .setup = clampSetup,
+            .updater = clampUpdate,
+            .handle = clampInit(127.0f, 0.0f),
+            .fixed = true
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .updater = NULL
+        }
+    };
+
     FlywheelSetup flywheelSetup =
     {
         .id = "flywheel",
         .pigeon = pigeon,
 
         .gearing = 1.0f,
-        .smoothing = 0.2f,
 
-        .controlSetup = tbhSetup,
-        .controlUpdater = tbhUpdate,
-        .controlResetter = tbhReset,
-        .control = tbhInit(0.2f, 10.0f, flywheelEstimator),
+        .stages = flywheelStages,
 
         .encoderGetter = encoderGetter,
         .encoderResetter = encoderResetter,
@@ -54,12 +129,16 @@ void initialize()
 
         .motorSetters =
         {
-            motorSetter
+            motorPostSetter
         },
         .motors =
         {
-            motorGetHandle(1, false)
+            motorPostGetHandle(1, false, MOTOR_PRIORITY_NORMAL)
         },
+        .motorWriteGetter = motorPostWriteGetter,
+
+        .profileRate = 3000.0f,
+        .profileJerk = 6000.0f,
 
         .priorityReady = 2,
         .priorityActive = 2,
@@ -70,6 +149,7 @@ void initialize()
         .thresholdDerivative = 100.0f,
         .checkCycle = 20,
 
+        .priorityEvents = TASK_PRIORITY_DEFAULT,
         .onready = flywheelReadied,
         .onreadyHandle = NULL,
         .onactive = flywheelActivated,
@@ -83,6 +163,7 @@ void initialize()
 static float
 flywheelEstimator(float target)
 {
+    if (target <= 0.0f) return 0.0f;
     return 18.195f + 2.2052e-5f * target * target;
 }
 
@@ -98,10 +179,24 @@ flywheelActivated(void * handle)
     UNUSED(handle);
 }
 
+// The pigeon task reads each line through here, so its monitor slot is
+// closed while it waits for a line and opened once one arrives. The pause
+// it takes after answering is counted with the line.
 static char *
 pigeonGets(char * buffer, int maxSize)
 {
-    return fgets(buffer, maxSize, stdout);
+    static int slot = -1;
+    static bool registered = false;
+    if (!registered)
+    {
+        slot = monitorRegister("pigeon");
+        registered = true;
+    }
+
+    monitorEnd(slot);
+    char * result = fgets(buffer, maxSize, stdin);
+    if (result != NULL) monitorBegin(slot);
+    return result;
 }
 
 static void
@@ -0,0 +1,90 @@
+#include "latency.h"
+
+#include <API.h>
+#include <stddef.h>
+
+#include "utils.h"
+
+
+#define NUMOFBUCKETS LATENCY_NUMOFBUCKETS
+#define FIRSTLIMIT 16
+
+
+void
+latencyInit(LatencyHistogram * histogram, const char * name)
+{
+    histogram->name = name;
+    latencyReset(histogram);
+}
+
+void
+latencyReset(LatencyHistogram * histogram)
+{
+    for (int i = 0; i < NUMOFBUCKETS; i++) histogram->counts[i] = 0;
+    histogram->total = 0;
+    histogram->max = 0;
+}
+
+void
+latencyRecord(LatencyHistogram * histogram, unsigned long micros)
+{
+    int bucket = 0;
+    unsigned long limit = FIRSTLIMIT;
+    while (micros >= limit && bucket < NUMOFBUCKETS - 1)
+    {
+        limit <<= 1;
+        bucket++;
+    }
+    histogram->counts[bucket]++;
+    histogram->total++;
+    if (micros > histogram->max) histogram->max = micros;
+}
+
+unsigned long
+latencyBucketLimit(int bucket)
+{
+    return FIRSTLIMIT << bucket;
+}
+
+unsigned long
+latencyPercentile(LatencyHistogram * histogram, float fraction)
+{
+    unsigned long wanted = histogram->total * fraction;
+    unsigned long seen = 0;
+    for (int i = 0; i < NUMOFBUCKETS - 1; i++)
+    {
+        seen += histogram->counts[i];
+        if (seen > wanted) return latencyBucketLimit(i);
+    }
+    return histogram->max;
+}
+
+void
+latencySummary(LatencyHistogram * histogram, char * destination, size_t size)
+{
+    snprintf(
+        destination,
+        size,
+        "%s n=%lu p50<%lu p90<%lu p99<%lu max=%lu",
+        histogram->name,
+        histogram->total,
+        latencyPercentile(histogram, 0.50f),
+        latencyPercentile(histogram, 0.90f),
+        latencyPercentile(histogram, 0.99f),
+        histogram->max
+    );
+}
+
+void
+latencyBuckets(LatencyHistogram * histogram, char * destination, size_t size)
+{
+    // Percentages, since whole counts do not fit on a pigeon line.
+    stringCopy(destination, histogram->name, size);
+    unsigned long total = histogram->total > 0? histogram->total : 1;
+    for (int i = 0; i < NUMOFBUCKETS; i++)
+    {
+        char percent[8];
+        snprintf(percent, sizeof(percent), " %lu", 100 * histogram->counts[i] / total);
+        stringAppend(destination, percent, size);
+    }
+}
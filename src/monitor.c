@@ -0,0 +1,285 @@
+#include "monitor.h"
+
+#include <API.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "pigeon.h"
+#include "utils.h"
+
+
+#define MAXTASKS MONITOR_MAXTASKS
+#define UNUSED(x) (void)(x)
+
+
+// The firmware's allocator keeps its break in _heapEnd and grows it up
+// toward the interrupt stack at the top of RAM, _estack. Both are weak, so
+// that builds without them, such as the host's, report no heap.
+extern char _estack[] __attribute__((weak));
+extern char * _heapEnd __attribute__((weak));
+
+
+// Typedefs {{{
+
+typedef struct
+MonitorTask
+{
+    const char * name;
+
+    volatile bool running;
+    volatile unsigned long start;
+    volatile unsigned long busy;
+
+    unsigned long lastBusy;
+    unsigned long share;
+}
+MonitorTask;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void task(void * data);
+static void update();
+static unsigned long heapFree();
+static void setupPortal(Pigeon*);
+static void taskHandler(void * handle, char * message, char * response);
+
+static MonitorTask tasks[MAXTASKS];
+static volatile int taskCount = 0;
+static Mutex mutex = NULL;
+
+static Portal * portal = NULL;
+static TaskHandle monitor = NULL;
+static unsigned long period = 1000;
+static unsigned long microTime = 0;
+static unsigned int count = 0;
+static unsigned long heap = 0;
+static unsigned long unaccounted = 0;
+
+static char * taskKeys[MAXTASKS] =
+{
+    "task-0",
+    "task-1",
+    "task-2",
+    "task-3",
+    "task-4",
+    "task-5",
+    "task-6",
+    "task-7",
+    "task-8",
+    "task-9",
+    "task-10",
+    "task-11",
+    "task-12",
+    "task-13",
+    "task-14",
+    "task-15"
+};
+
+// }}}
+
+
+
+// Public methods {{{
+
+int
+monitorRegister(const char * name)
+{
+    if (mutex == NULL) mutex = mutexCreate();
+
+    mutexTake(mutex, -1);
+    if (taskCount >= MAXTASKS)
+    {
+        mutexGive(mutex);
+        return -1;
+    }
+    int slot = taskCount;
+    MonitorTask * monitored = &tasks[slot];
+    monitored->name = name;
+    monitored->running = false;
+    monitored->start = 0;
+    monitored->busy = 0;
+    monitored->lastBusy = 0;
+    monitored->share = 0;
+    taskCount++;
+    mutexGive(mutex);
+
+    return slot;
+}
+
+void
+monitorBegin(int slot)
+{
+    if (slot < 0 || slot >= MAXTASKS) return;
+    tasks[slot].start = micros();
+    tasks[slot].running = true;
+}
+
+void
+monitorEnd(int slot)
+{
+    if (slot < 0 || slot >= MAXTASKS) return;
+    if (!tasks[slot].running) return;
+    tasks[slot].busy += micros() - tasks[slot].start;
+    tasks[slot].running = false;
+}
+
+void
+monitorInit(Pigeon * pigeon, unsigned long monitorPeriod, unsigned int priority)
+{
+    if (monitor != NULL) return;
+    if (mutex == NULL) mutex = mutexCreate();
+    period = monitorPeriod;
+    microTime = micros();
+    setupPortal(pigeon);
+    monitor = taskCreate(task, TASK_DEFAULT_STACK_SIZE, NULL, priority);
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+task(void * data)
+{
+    UNUSED(data);
+    int slot = monitorRegister("monitor");
+    unsigned long wakeTime = millis();
+    while (true)
+    {
+        monitorBegin(slot);
+        update();
+        portalFlush(portal);
+        monitorEnd(slot);
+        taskDelayUntil(&wakeTime, period);
+    }
+}
+
+static void
+update()
+{
+    unsigned long now = micros();
+    unsigned long elapsed = now - microTime;
+    microTime = now;
+    if (elapsed == 0) elapsed = 1;
+
+    // Shares are in tenths of a percent.
+    unsigned long accounted = 0;
+    int monitoredCount = taskCount;
+    for (int i = 0; i < monitoredCount; i++)
+    {
+        MonitorTask * monitored = &tasks[i];
+        unsigned long busy = monitored->busy;
+        unsigned long busyChange = busy - monitored->lastBusy;
+        monitored->lastBusy = busy;
+        monitored->share = (unsigned long long)busyChange * 1000 / elapsed;
+        accounted += monitored->share;
+
+        portalUpdate(portal, taskKeys[i]);
+    }
+    unaccounted = accounted < 1000? 1000 - accounted : 0;
+    count = taskGetCount();
+    heap = heapFree();
+
+    portalUpdate(portal, "tasks");
+    portalUpdate(portal, "heap");
+    portalUpdate(portal, "unaccounted");
+}
+
+// Only what lies above the break: blocks freed below it are not counted,
+// and the interrupt stack takes some of the top.
+static unsigned long
+heapFree()
+{
+    if (&_heapEnd == NULL || _estack == NULL) return 0;
+    if (_heapEnd >= _estack) return 0;
+    return _estack - _heapEnd;
+}
+
+static void
+setupPortal(Pigeon * pigeon)
+{
+    portal = pigeonCreatePortal(pigeon, "system");
+
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "tasks",
+            .handler = portalUintHandler,
+            .handle = &count
+        },
+        {
+            .key = "heap",
+            .handler = portalUlongHandler,
+            .handle = &heap,
+            .stream = true
+        },
+        {
+            .key = "unaccounted",
+            .handler = portalUlongHandler,
+            .handle = &unaccounted,
+            .stream = true
+        },
+        {
+            .key = "period",
+            .handler = portalUlongHandler,
+            .handle = &period
+        },
+        {
+            .key = "keys",
+            .handler = portalStreamKeyHandler,
+            .handle = portal
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+
+    for (int i = 0; i < MAXTASKS; i++)
+    {
+        PortalEntrySetup setup =
+        {
+            .key = taskKeys[i],
+            .handler = taskHandler,
+            .handle = &tasks[i]
+        };
+        portalAdd(portal, setup);
+    }
+
+    portalReady(portal);
+}
+
+// "<name> cpu=<percent>"
+static void
+taskHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    UNUSED(message);
+    MonitorTask * monitored = handle;
+    if (monitored - tasks >= taskCount)
+    {
+        strcpy(response, "none");
+        return;
+    }
+    sprintf(
+        response,
+        "%s cpu=%lu.%lu%%",
+        monitored->name,
+        monitored->share / 10,
+        monitored->share % 10
+    );
+}
+
+// }}}
@@ -0,0 +1,197 @@
+#include "motors.h"
+
+#include <API.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "battery.h"
+#include "monitor.h"
+
+
+#define NUMOFPORTS MOTORS_NUMOFPORTS
+#define NUMOFPRIORITIES MOTOR_NUMOFPRIORITIES
+#define RELEASED INT_MIN
+// Copies tried before a reader that keeps landing on a publish sleeps.
+#define SPINS 4
+#define UNUSED(x) (void)(x)
+
+
+// Each slot is a single word, so posting needs no lock. Its post time is
+// stored after it, and is only taken up once it differs from the last.
+static volatile int commands[NUMOFPORTS][NUMOFPRIORITIES];
+static volatile unsigned long postTimes[NUMOFPORTS][NUMOFPRIORITIES];
+// Set by a port's first post; the writer leaves ports never posted to
+// alone, so they stay free for motorSet.
+static volatile bool claimed[NUMOFPORTS];
+static bool compensated[NUMOFPORTS];
+static int written[NUMOFPORTS];
+// micros() right after each port's last motorSet.
+static unsigned long setTimes[NUMOFPORTS];
+
+// Odd while the writer is publishing what it took up.
+static volatile unsigned long sequence = 0;
+static volatile MotorsWrite takenUp[NUMOFPORTS][NUMOFPRIORITIES];
+static unsigned long writeCount = 0;
+static unsigned long period = 20;
+static TaskHandle writer = NULL;
+
+static void task(void * data);
+static void writePorts();
+static void takeUp(int port, int level, unsigned long now);
+static int compensate(int command, float scale);
+
+
+void
+motorsInit(unsigned long writePeriod, unsigned int priority)
+{
+    if (writer != NULL) return;
+    for (int port = 0; port < NUMOFPORTS; port++)
+    {
+        for (int level = 0; level < NUMOFPRIORITIES; level++)
+        {
+            commands[port][level] = RELEASED;
+            postTimes[port][level] = 0;
+            takenUp[port][level].postTime = 0;
+            takenUp[port][level].writeTime = 0;
+        }
+        claimed[port] = false;
+        compensated[port] = false;
+        written[port] = 0;
+        setTimes[port] = micros();
+    }
+    period = writePeriod;
+    writer = taskCreate(task, TASK_DEFAULT_STACK_SIZE, NULL, priority);
+}
+
+void
+motorsPost(unsigned char channel, MotorPriority priority, int command)
+{
+    if (channel < 1 || channel > NUMOFPORTS) return;
+    if (priority >= NUMOFPRIORITIES) return;
+    if (command > 127) command = 127;
+    if (command < -127) command = -127;
+    // Stamped before the command is stored, so a writer that runs in
+    // between and sends the command has a set time after the stamp.
+    unsigned long now = micros();
+    commands[channel - 1][priority] = command;
+    postTimes[channel - 1][priority] = now;
+    claimed[channel - 1] = true;
+}
+
+void
+motorsRelease(unsigned char channel, MotorPriority priority)
+{
+    if (channel < 1 || channel > NUMOFPORTS) return;
+    if (priority >= NUMOFPRIORITIES) return;
+    commands[channel - 1][priority] = RELEASED;
+}
+
+void
+motorsCompensate(unsigned char channel, bool compensate)
+{
+    if (channel < 1 || channel > NUMOFPORTS) return;
+    compensated[channel - 1] = compensate;
+}
+
+int
+motorsGetWritten(unsigned char channel)
+{
+    if (channel < 1 || channel > NUMOFPORTS) return 0;
+    return written[channel - 1];
+}
+
+unsigned long
+motorsGetWriteCount()
+{
+    return writeCount;
+}
+
+bool
+motorsGetWrite(unsigned char channel, MotorPriority priority, MotorsWrite * write)
+{
+    if (channel < 1 || channel > NUMOFPORTS) return false;
+    if (priority >= NUMOFPRIORITIES) return false;
+    for (unsigned int tries = 1; ; tries++)
+    {
+        unsigned long before = sequence;
+        __sync_synchronize();
+        *write = takenUp[channel - 1][priority];
+        __sync_synchronize();
+        if (before % 2 == 0 && sequence == before) break;
+        if (tries >= SPINS) delay(1);
+    }
+    return write->postTime != 0;
+}
+
+
+static void
+task(void * data)
+{
+    UNUSED(data);
+    int slot = monitorRegister("motors");
+    unsigned long wakeTime = millis();
+    while (true)
+    {
+        monitorBegin(slot);
+        writePorts();
+        monitorEnd(slot);
+        taskDelayUntil(&wakeTime, period);
+    }
+}
+
+static void
+writePorts()
+{
+    float scale = batteryGetScale();
+    sequence++;
+    __sync_synchronize();
+    for (int port = 0; port < NUMOFPORTS; port++)
+    {
+        if (!claimed[port]) continue;
+        int command = 0;
+        int level = NUMOFPRIORITIES - 1;
+        for (; level >= 0; level--)
+        {
+            int posted = commands[port][level];
+            if (posted != RELEASED)
+            {
+                command = posted;
+                break;
+            }
+        }
+        if (compensated[port]) command = compensate(command, scale);
+        // Checked against the port as well, since the kernel stops every
+        // port when the robot is disabled without the task knowing.
+        if (command != written[port] || command != motorGet(port + 1))
+        {
+            motorSet(port + 1, command);
+            setTimes[port] = micros();
+            written[port] = command;
+            writeCount++;
+        }
+        if (level >= 0) takeUp(port, level, micros());
+    }
+    __sync_synchronize();
+    sequence++;
+}
+
+// A post already sent by an earlier pass, as one that landed mid-post
+// would be, was written at that pass's set time.
+static void
+takeUp(int port, int level, unsigned long now)
+{
+    unsigned long postTime = postTimes[port][level];
+    if (postTime == takenUp[port][level].postTime) return;
+    bool setSince = (long)(setTimes[port] - postTime) >= 0;
+    takenUp[port][level].postTime = postTime;
+    takenUp[port][level].writeTime = setSince? setTimes[port] : now;
+}
+
+static int
+compensate(int command, float scale)
+{
+    float scaled = command * scale;
+    if (scaled > 127.0f) return 127;
+    if (scaled < -127.0f) return -127;
+    return scaled + (scaled < 0.0f? -0.5f : 0.5f);
+}
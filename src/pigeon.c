@@ -533,6 +533,15 @@ portalUlongHandler(void * handle, char * msg, char * res)
 }
 
 
+void
+portalPeriodHandler(void * handle, char * msg, char * res)
+{
+    unsigned long value;
+    if (msg != NULL && (!stringToUlong(msg, &value) || value == 0)) return;
+    portalUlongHandler(handle, msg, res);
+}
+
+
 void
 portalBoolHandler(void * handle, char * msg, char * res)
 {
@@ -574,7 +583,7 @@ task(void * pigeonData)
     while (true)
     {
         char input[LINESIZE];
-        char * result = fgets(input, LINESIZE, stdin);
+        char * result = pigeon->gets(input, LINESIZE);
         if (result == NULL) continue;
 
         char * inputTrimmed = trimSpaces(input);
@@ -0,0 +1,300 @@
+#include "pipeline.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "control.h"
+#include "pigeon.h"
+#include "utils.h"
+
+
+#define LINESIZE PIGEON_LINESIZE
+#define MAXSTAGES PIPELINE_MAXSTAGES
+#define UNUSED(x) (void)(x)
+
+
+
+// Structs {{{
+
+typedef struct
+PipelineStage
+{
+    const char * key;
+    char * timingKey;
+    ControlUpdater update;
+    ControlResetter reset;
+    ControlHandle handle;
+    bool fixed;
+
+    unsigned long microsLast;
+    unsigned long microsMax;
+}
+PipelineStage;
+
+typedef struct
+PipelineOrder
+{
+    unsigned int count;
+    PipelineStage * stages[MAXSTAGES];
+}
+PipelineOrder;
+
+struct Pipeline
+{
+    Portal * portal;
+
+    PipelineStage stages[MAXSTAGES];
+    unsigned int stageCount;
+
+    // Pigeon reorders the stages from its own task, so the owning task
+    // takes a copy of the order under the lock each update and runs
+    // through that.
+    PipelineOrder order;
+    Mutex mutex;
+};
+
+// }}}
+
+
+
+// Private functions - forward declarations {{{
+
+static PipelineStage * findStage(Pipeline*, const char * key);
+static void orderHandler(void * handle, char * message, char * response);
+static void timingHandler(void * handle, char * message, char * response);
+
+// }}}
+
+
+
+// Public methods {{{
+
+Pipeline *
+pipelineInit(Portal * portal)
+{
+    Pipeline * pipeline = malloc(sizeof(Pipeline));
+    pipeline->portal = portal;
+    pipeline->stageCount = 0;
+    pipeline->order.count = 0;
+    pipeline->mutex = mutexCreate();
+
+    PortalEntrySetup setup =
+    {
+        .key = "stages",
+        .handler = orderHandler,
+        .handle = pipeline
+    };
+    portalAdd(portal, setup);
+
+    return pipeline;
+}
+
+
+void
+pipelineAdd(Pipeline * pipeline, PipelineStageSetup setup)
+{
+    if (pipeline == NULL) return;
+    if (pipeline->stageCount >= MAXSTAGES) return;
+    if (setup.updater == NULL) return;
+
+    PipelineStage * stage = &pipeline->stages[pipeline->stageCount];
+    pipeline->stageCount++;
+
+    stage->key = setup.key;
+    stage->update = setup.updater;
+    stage->reset = setup.resetter;
+    stage->handle = setup.handle;
+    stage->fixed = setup.fixed;
+    stage->microsLast = 0;
+    stage->microsMax = 0;
+
+    // Stages added at init are all active, in the order they were added,
+    // except that the fixed ones stay last.
+    mutexTake(pipeline->mutex, -1);
+    PipelineOrder * order = &pipeline->order;
+    unsigned int position = order->count;
+    while (!stage->fixed && position > 0 && order->stages[position - 1]->fixed)
+    {
+        order->stages[position] = order->stages[position - 1];
+        position--;
+    }
+    order->stages[position] = stage;
+    order->count++;
+    mutexGive(pipeline->mutex);
+
+    size_t timingKeySize = strlen(setup.key) + sizeof("-micros");
+    stage->timingKey = malloc(timingKeySize);
+    snprintf(stage->timingKey, timingKeySize, "%s-micros", setup.key);
+
+    PortalEntrySetup timingSetup =
+    {
+        .key = stage->timingKey,
+        .handler = timingHandler,
+        .handle = stage
+    };
+    portalAdd(pipeline->portal, timingSetup);
+
+    if (setup.setup != NULL)
+    {
+        setup.setup(setup.handle, pipeline->portal);
+    }
+}
+
+
+void
+pipelineAddBatch(Pipeline * pipeline, PipelineStageSetup * setup)
+{
+    while (true)
+    {
+        if (setup->key[0] == '~' && setup->updater == NULL)
+        {
+            break;
+        }
+        pipelineAdd(pipeline, *setup);
+        setup++;
+    }
+}
+
+
+void
+pipelineUpdate(Pipeline * pipeline, ControlSystem * system)
+{
+    mutexTake(pipeline->mutex, -1);
+    PipelineOrder order = pipeline->order;
+    mutexGive(pipeline->mutex);
+
+    PipelineStage ** stage = order.stages;
+    PipelineStage ** end = stage + order.count;
+
+    unsigned long start = micros();
+    for (; stage < end; stage++)
+    {
+        (*stage)->update((*stage)->handle, system);
+
+        unsigned long finish = micros();
+        unsigned long elapsed = finish - start;
+        (*stage)->microsLast = elapsed;
+        if (elapsed > (*stage)->microsMax) (*stage)->microsMax = elapsed;
+        start = finish;
+    }
+}
+
+
+void
+pipelineReset(Pipeline * pipeline)
+{
+    // Reset every registered stage, so disabled stages start clean if they
+    // are switched back in.
+    for (unsigned int i = 0; i < pipeline->stageCount; i++)
+    {
+        PipelineStage * stage = &pipeline->stages[i];
+        if (stage->reset != NULL) stage->reset(stage->handle);
+        stage->microsMax = 0;
+    }
+}
+
+
+void
+pipelineGetOrder(Pipeline * pipeline, char * destination)
+{
+    mutexTake(pipeline->mutex, -1);
+    PipelineOrder order = pipeline->order;
+    mutexGive(pipeline->mutex);
+
+    destination[0] = '\0';
+    for (unsigned int i = 0; i < order.count; i++)
+    {
+        if (i > 0) stringAppend(destination, " ", LINESIZE);
+        stringAppend(destination, order.stages[i]->key, LINESIZE);
+    }
+}
+
+
+// Note: sequence will be modified
+bool
+pipelineSetOrder(Pipeline * pipeline, char * sequence)
+{
+    PipelineOrder next = {0};
+    bool named[MAXSTAGES] = {false};
+    char * key = strtok(sequence, " ");
+    while (key != NULL)
+    {
+        PipelineStage * stage = findStage(pipeline, key);
+        if (stage == NULL) return false;
+        unsigned int index = stage - pipeline->stages;
+        if (named[index]) return false;
+        named[index] = true;
+        if (!stage->fixed)
+        {
+            next.stages[next.count] = stage;
+            next.count++;
+        }
+        key = strtok(NULL, " ");
+    }
+    if (next.count == 0) return false;
+
+    for (unsigned int i = 0; i < pipeline->stageCount; i++)
+    {
+        PipelineStage * stage = &pipeline->stages[i];
+        if (!stage->fixed) continue;
+        next.stages[next.count] = stage;
+        next.count++;
+    }
+
+    // The running task only ever copies the order whole, so it finishes
+    // the frame in the old order and starts the next in this one.
+    mutexTake(pipeline->mutex, -1);
+    pipeline->order = next;
+    mutexGive(pipeline->mutex);
+    return true;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static PipelineStage *
+findStage(Pipeline * pipeline, const char * key)
+{
+    for (unsigned int i = 0; i < pipeline->stageCount; i++)
+    {
+        if (strcmp(pipeline->stages[i].key, key) == 0)
+        {
+            return &pipeline->stages[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+orderHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    Pipeline * pipeline = handle;
+    if (message == NULL) pipelineGetOrder(pipeline, response);
+    else pipelineSetOrder(pipeline, message);
+}
+
+static void
+timingHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    PipelineStage * stage = handle;
+    if (message == NULL)
+    {
+        sprintf(response, "%lu %lu", stage->microsLast, stage->microsMax);
+    }
+    else
+    {
+        // Writing anything clears the worst case.
+        stage->microsMax = 0;
+    }
+}
+
+// }}}
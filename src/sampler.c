@@ -0,0 +1,259 @@
+#include "sampler.h"
+
+#include <API.h>
+#include <stdbool.h>
+
+#include "monitor.h"
+#include "pigeon.h"
+
+
+#define MAXSENSORS SAMPLER_MAXSENSORS
+// Copies tried before a reader that keeps landing on a publish sleeps.
+#define SPINS 4
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+typedef struct
+Sensor
+{
+    SamplerReader reader;
+    void * handle;
+    unsigned long interval;
+    unsigned long readTime;
+}
+Sensor;
+
+// }}}
+
+
+
+// Private functions, forward declarations {{{
+
+static void task(void * data);
+static void sweep();
+static bool isDue(Sensor*, unsigned long now);
+static SamplerSample readSensor(Sensor*);
+static void setupPortal(Pigeon*);
+
+static Sensor sensors[MAXSENSORS];
+static volatile unsigned int sensorCount = 0;
+static Mutex mutex = NULL;
+
+// Odd while a sweep is being published.
+static volatile unsigned long sequence = 0;
+static volatile SamplerSample table[MAXSENSORS];
+static unsigned long sweeps = 0;
+static unsigned long retries = 0;
+
+static Portal * portal = NULL;
+static TaskHandle sampler = NULL;
+static unsigned long period = 10;
+
+// }}}
+
+
+
+// Public methods {{{
+
+void
+samplerInit(Pigeon * pigeon, unsigned long samplePeriod, unsigned int priority)
+{
+    if (sampler != NULL) return;
+    if (mutex == NULL) mutex = mutexCreate();
+    period = samplePeriod;
+    setupPortal(pigeon);
+    sampler = taskCreate(task, TASK_DEFAULT_STACK_SIZE, NULL, priority);
+}
+
+int
+samplerAdd(SamplerReader reader, void * handle)
+{
+    return samplerAddEvery(reader, handle, 0);
+}
+
+// A new slot is filled before it is counted, so neither the task nor any
+// reader sees it half made.
+int
+samplerAddEvery(SamplerReader reader, void * handle, unsigned long interval)
+{
+    if (reader == NULL) return -1;
+    if (mutex == NULL) mutex = mutexCreate();
+
+    mutexTake(mutex, -1);
+    unsigned int count = sensorCount;
+    for (unsigned int slot = 0; slot < count; slot++)
+    {
+        if (sensors[slot].reader == reader && sensors[slot].handle == handle)
+        {
+            mutexGive(mutex);
+            return slot;
+        }
+    }
+    if (count >= MAXSENSORS)
+    {
+        mutexGive(mutex);
+        return -1;
+    }
+    sensors[count].reader = reader;
+    sensors[count].handle = handle;
+    sensors[count].interval = interval;
+    sensors[count].readTime = millis();
+    table[count] = readSensor(&sensors[count]);
+    __sync_synchronize();
+    sensorCount = count + 1;
+    mutexGive(mutex);
+
+    return count;
+}
+
+SamplerSample
+samplerGet(int slot)
+{
+    SamplerSample sample = {0};
+    samplerGetMany(&slot, 1, &sample);
+    return sample;
+}
+
+void
+samplerGetMany(const int slots[], unsigned int count, SamplerSample samples[])
+{
+    unsigned int registered = sensorCount;
+    for (unsigned int tries = 1; ; tries++)
+    {
+        unsigned long before = sequence;
+        __sync_synchronize();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            int slot = slots[i];
+            if (slot < 0 || (unsigned int)slot >= registered) continue;
+            samples[i] = table[slot];
+        }
+        __sync_synchronize();
+        if (before % 2 == 0 && sequence == before) return;
+
+        retries++;
+        if (tries >= SPINS) delay(1);
+    }
+}
+
+unsigned long
+samplerGetSweepCount()
+{
+    return sweeps;
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static void
+task(void * data)
+{
+    UNUSED(data);
+    int slot = monitorRegister("sampler");
+    unsigned long wakeTime = millis();
+    while (true)
+    {
+        monitorBegin(slot);
+        sweep();
+        monitorEnd(slot);
+        taskDelayUntil(&wakeTime, period);
+    }
+}
+
+// Sensors are read into a local table first, so the sequence is only odd
+// for the copy. Only this task writes the table, so sensors not yet due
+// can be carried over from it.
+static void
+sweep()
+{
+    SamplerSample fresh[MAXSENSORS];
+    unsigned int count = sensorCount;
+    unsigned long now = millis();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (!isDue(&sensors[i], now))
+        {
+            fresh[i] = table[i];
+            continue;
+        }
+        fresh[i] = readSensor(&sensors[i]);
+        fresh[i].sweep = sweeps + 1;
+    }
+
+    sequence++;
+    __sync_synchronize();
+    for (unsigned int i = 0; i < count; i++) table[i] = fresh[i];
+    __sync_synchronize();
+    sequence++;
+    sweeps++;
+}
+
+static bool
+isDue(Sensor * sensor, unsigned long now)
+{
+    if (now - sensor->readTime < sensor->interval) return false;
+    sensor->readTime = now;
+    return true;
+}
+
+static SamplerSample
+readSensor(Sensor * sensor)
+{
+    unsigned long before = micros();
+    int value = sensor->reader(sensor->handle);
+    unsigned long after = micros();
+
+    SamplerSample sample =
+    {
+        .value = value,
+        .microTime = before + (after - before) / 2,
+        .sweep = sweeps
+    };
+    return sample;
+}
+
+static void
+setupPortal(Pigeon * pigeon)
+{
+    portal = pigeonCreatePortal(pigeon, "sampler");
+
+    PortalEntrySetup setups[] =
+    {
+        {
+            .key = "sensors",
+            .handler = portalUintHandler,
+            .handle = (unsigned int *)&sensorCount
+        },
+        {
+            .key = "sweeps",
+            .handler = portalUlongHandler,
+            .handle = &sweeps
+        },
+        {
+            .key = "retries",
+            .handler = portalUlongHandler,
+            .handle = &retries
+        },
+        {
+            .key = "period",
+            .handler = portalPeriodHandler,
+            .handle = &period
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .handler = NULL,
+            .handle = NULL
+        }
+    };
+    portalAddBatch(portal, setups);
+    portalReady(portal);
+}
+
+// }}}
@@ -0,0 +1,314 @@
+#include "schedule.h"
+
+#include <API.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "control.h"
+#include "pigeon.h"
+#include "utils.h"
+
+
+#define MAXROWS SCHEDULE_MAXROWS
+#define UNUSED(x) (void)(x)
+
+
+// Typedefs {{{
+
+struct Schedule;
+typedef struct Schedule Schedule;
+
+typedef struct
+ScheduleRow
+{
+    float target;
+    float gainP;
+    float gainI;
+    float gainD;
+}
+ScheduleRow;
+
+typedef struct
+ScheduleRowEntry
+{
+    Schedule * schedule;
+    int index;
+}
+ScheduleRowEntry;
+
+struct Schedule
+{
+    Portal * portal;
+    ControlGainSetter setGains;
+    ControlHandle control;
+
+    ScheduleRow rows[MAXROWS];
+    int rowCount;
+    ScheduleRowEntry rowEntries[MAXROWS];
+    // The portal edits the rows from its own task while the flywheel task
+    // interpolates them, so both hold this.
+    Mutex mutex;
+
+    float lastGoal;
+    volatile bool dirty;
+};
+
+// }}}
+
+
+
+// Private functions - forward declarations {{{
+
+static bool setRow(Schedule*, float target, float gainP, float gainI, float gainD);
+static void removeRow(Schedule*, int index);
+static void interpolate(Schedule*, float target, ScheduleRow * result);
+static void rowHandler(void * handle, char * message, char * response);
+
+static char * rowKeys[MAXROWS] =
+{
+    "schedule-0",
+    "schedule-1",
+    "schedule-2",
+    "schedule-3",
+    "schedule-4",
+    "schedule-5",
+    "schedule-6",
+    "schedule-7"
+};
+
+// }}}
+
+
+
+// Public methods {{{
+
+ControlHandle
+scheduleInit(ControlGainSetter setGains, ControlHandle control)
+{
+    Schedule * schedule = malloc(sizeof(Schedule));
+    schedule->portal = NULL;
+    schedule->setGains = setGains;
+    schedule->control = control;
+    schedule->rowCount = 0;
+    schedule->mutex = mutexCreate();
+    for (int i = 0; i < MAXROWS; i++)
+    {
+        schedule->rowEntries[i].schedule = schedule;
+        schedule->rowEntries[i].index = i;
+    }
+    scheduleReset(schedule);
+    return schedule;
+}
+
+bool
+scheduleSetRow(
+    ControlHandle handle,
+    float target,
+    float gainP,
+    float gainI,
+    float gainD
+){
+    Schedule * schedule = handle;
+    mutexTake(schedule->mutex, -1);
+    bool set = setRow(schedule, target, gainP, gainI, gainD);
+    mutexGive(schedule->mutex);
+    return set;
+}
+
+void
+scheduleReset(ControlHandle handle)
+{
+    Schedule * schedule = handle;
+    schedule->lastGoal = 0.0f;
+    schedule->dirty = true;
+}
+
+float
+scheduleUpdate(ControlHandle handle, ControlSystem * system)
+{
+    Schedule * schedule = handle;
+
+    // Nothing to do between goal changes. The setpoint moves every frame
+    // of a profile, but the gains are scheduled for where it is heading.
+    if (!schedule->dirty && system->goal == schedule->lastGoal)
+    {
+        return system->action;
+    }
+    schedule->dirty = false;
+    schedule->lastGoal = system->goal;
+
+    mutexTake(schedule->mutex, -1);
+    bool empty = schedule->rowCount == 0;
+    ScheduleRow gains;
+    if (!empty) interpolate(schedule, system->goal, &gains);
+    mutexGive(schedule->mutex);
+
+    if (empty) return system->action;
+    schedule->setGains(schedule->control, gains.gainP, gains.gainI, gains.gainD);
+
+    return system->action;
+}
+
+void
+scheduleSetup(ControlHandle handle, Portal * portal)
+{
+    Schedule * schedule = handle;
+    schedule->portal = portal;
+    for (int i = 0; i < MAXROWS; i++)
+    {
+        PortalEntrySetup setup =
+        {
+            .key = rowKeys[i],
+            .handler = rowHandler,
+            .handle = &schedule->rowEntries[i]
+        };
+        portalAdd(portal, setup);
+    }
+}
+
+void
+scheduleSetGains(ControlHandle handle, float gainP, float gainI, float gainD)
+{
+    Schedule * schedule = handle;
+    scheduleSetRow(schedule, schedule->lastGoal, gainP, gainI, gainD);
+    for (int i = 0; i < schedule->rowCount; i++)
+    {
+        portalUpdate(schedule->portal, rowKeys[i]);
+    }
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+// Inserts the row in target order, replacing any row at the same target.
+static bool
+setRow(Schedule * schedule, float target, float gainP, float gainI, float gainD)
+{
+    int i = 0;
+    while (i < schedule->rowCount && schedule->rows[i].target < target) i++;
+
+    bool replacing = i < schedule->rowCount && schedule->rows[i].target == target;
+    if (!replacing)
+    {
+        if (schedule->rowCount >= MAXROWS) return false;
+        for (int j = schedule->rowCount; j > i; j--)
+        {
+            schedule->rows[j] = schedule->rows[j - 1];
+        }
+        schedule->rowCount++;
+    }
+
+    schedule->rows[i].target = target;
+    schedule->rows[i].gainP = gainP;
+    schedule->rows[i].gainI = gainI;
+    schedule->rows[i].gainD = gainD;
+    schedule->dirty = true;
+    return true;
+}
+
+static void
+removeRow(Schedule * schedule, int index)
+{
+    if (index >= schedule->rowCount) return;
+    schedule->rowCount--;
+    for (int i = index; i < schedule->rowCount; i++)
+    {
+        schedule->rows[i] = schedule->rows[i + 1];
+    }
+    schedule->dirty = true;
+}
+
+static void
+interpolate(Schedule * schedule, float target, ScheduleRow * result)
+{
+    ScheduleRow * rows = schedule->rows;
+    int last = schedule->rowCount - 1;
+
+    // Hold the end rows outside of the table.
+    if (target <= rows[0].target)
+    {
+        *result = rows[0];
+        return;
+    }
+    if (target >= rows[last].target)
+    {
+        *result = rows[last];
+        return;
+    }
+
+    int i = 1;
+    while (rows[i].target < target) i++;
+    ScheduleRow * low = &rows[i - 1];
+    ScheduleRow * high = &rows[i];
+
+    float t = (target - low->target) / (high->target - low->target);
+    result->target = target;
+    result->gainP = low->gainP + t * (high->gainP - low->gainP);
+    result->gainI = low->gainI + t * (high->gainI - low->gainI);
+    result->gainD = low->gainD + t * (high->gainD - low->gainD);
+}
+
+// Rows read and write as "target gain-p gain-i gain-d", or "none" to
+// remove. Rows are kept sorted, so an edited row may move.
+static void
+rowHandler(void * handle, char * message, char * response)
+{
+    if (handle == NULL) return;
+    if (response == NULL) return;
+    ScheduleRowEntry * entry = handle;
+    Schedule * schedule = entry->schedule;
+
+    if (message == NULL)
+    {
+        mutexTake(schedule->mutex, -1);
+        bool present = entry->index < schedule->rowCount;
+        ScheduleRow row;
+        if (present) row = schedule->rows[entry->index];
+        mutexGive(schedule->mutex);
+
+        if (!present)
+        {
+            strcpy(response, "none");
+            return;
+        }
+        sprintf(
+            response,
+            "%f %f %f %f",
+            row.target,
+            row.gainP,
+            row.gainI,
+            row.gainD
+        );
+        return;
+    }
+
+    if (strcmp(message, "none") == 0)
+    {
+        mutexTake(schedule->mutex, -1);
+        removeRow(schedule, entry->index);
+        mutexGive(schedule->mutex);
+        return;
+    }
+
+    float values[4];
+    char * token = strtok(message, " ");
+    for (int i = 0; i < 4; i++)
+    {
+        if (token == NULL) return;
+        if (!stringToFloat(token, &values[i])) return;
+        token = strtok(NULL, " ");
+    }
+
+    // Removed and reinserted under one lock, so the flywheel never sees
+    // the row missing.
+    mutexTake(schedule->mutex, -1);
+    removeRow(schedule, entry->index);
+    setRow(schedule, values[0], values[1], values[2], values[3]);
+    mutexGive(schedule->mutex);
+}
+
+// }}}
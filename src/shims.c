@@ -2,9 +2,33 @@
 
 #include <API.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "imes.h"
+#include "motors.h"
+#include "sampler.h"
 #include "utils.h"
 
 
+// Gyro drift: a still window, the most it may turn and still count as
+// still, and how far each still window moves the estimate.
+#define GYRO_STILLWINDOW 2.0f
+#define GYRO_STILLDEGREES 2
+#define GYRO_BIASGAIN 0.25f
+#define ULTRASONIC_NONE (-1)
+
+
+static int readEncoder(void * handle);
+static int readImeCount(void * handle);
+static int readImeVelocity(void * handle);
+static int readDigital(void * handle);
+static int readAnalog(void * handle);
+static int readGyroDegrees(void * handle);
+static int readGyroRate(void * handle);
+static int readUltrasonic(void * handle);
+static int median(const int values[], unsigned int count);
+static float slope(const float times[], const float values[], unsigned int count);
+
+
 const float SHIM_DEGREES_PER_REV = 360.0f;
 const float SHIM_RADIANS_PER_REV = TAU;
 
@@ -20,9 +44,13 @@ const float ENCODER_GEARING_IME_393_SPEED = 24.5f;
 typedef struct
 EncoderShim
 {
-    Encoder encoder;
+    int slot;
+    int zero;
+    // The last sample speed was taken from, and that speed. Any task may
+    // read the handle, so these are guarded by the mutex.
     int ticks;
     unsigned long microTime;
+    float rpm;
     Mutex mutex;
 }
 EncoderShim;
@@ -31,45 +59,156 @@ EncoderReading
 encoderGetter(EncoderHandle handle)
 {
     EncoderShim * shim = handle;
+    SamplerSample sample = samplerGet(shim->slot);
 
+    // Read again within the same sweep, the speed stands.
     mutexTake(shim->mutex, -1);
+    float minutes = (sample.microTime - shim->microTime) / 60e6f;
+    if (minutes > 0.0f)
+    {
+        int ticksChange = sample.value - shim->ticks;
+        shim->rpm = ticksChange / TICKS_PER_REV_ENCODER / minutes;
+        shim->ticks = sample.value;
+        shim->microTime = sample.microTime;
+    }
+    float rpm = shim->rpm;
+    mutexGive(shim->mutex);
 
-    float minutes = timeUpdate(&shim->microTime) / 60.0f;
-    int ticks = encoderGet(shim->encoder);
-    int ticksChange = ticks - shim->ticks;
-
-    float revolutions = ((float)ticks) / TICKS_PER_REV_ENCODER;
-    shim->ticks = ticks;
-
-    float rpm = ticksChange / TICKS_PER_REV_ENCODER / minutes;
     EncoderReading reading =
     {
-        .revolutions = revolutions,
-        .rpm = rpm
+        .revolutions = ((float)(sample.value - shim->zero)) / TICKS_PER_REV_ENCODER,
+        .rpm = rpm,
+        .microTime = sample.microTime
     };
+    return reading;
+}
+
+float
+encoderPositionGetter(EncoderHandle handle)
+{
+    EncoderShim * shim = handle;
+    int ticks = samplerGet(shim->slot).value;
+    return ((float)(ticks - shim->zero)) / TICKS_PER_REV_ENCODER;
+}
+
+void
+encoderResetter(EncoderHandle handle)
+{
+    EncoderShim * shim = handle;
+    shim->zero = samplerGet(shim->slot).value;
+}
 
+EncoderHandle
+encoderGetHandle(Encoder encoder)
+{
+    EncoderShim * shim = malloc(sizeof(EncoderShim));
+    shim->slot = samplerAdd(readEncoder, encoder);
+    SamplerSample sample = samplerGet(shim->slot);
+    shim->zero = 0;
+    shim->ticks = sample.value;
+    shim->microTime = sample.microTime;
+    shim->rpm = 0.0f;
+    shim->mutex = mutexCreate();
+    return shim;
+}
+
+typedef struct
+EncoderFitSample
+{
+    int ticks;
+    unsigned long microTime;
+}
+EncoderFitSample;
+
+typedef struct
+EncoderFitShim
+{
+    int slot;
+    int zero;
+    // The window, guarded by the mutex as any task may read the handle.
+    EncoderFitSample samples[SHIM_FITMAXWINDOW];
+    unsigned long sweep;
+    unsigned int newest;
+    unsigned int count;
+    unsigned int window;
+    Mutex mutex;
+}
+EncoderFitShim;
+
+EncoderReading
+encoderFitGetter(EncoderHandle handle)
+{
+    EncoderFitShim * shim = handle;
+    SamplerSample sample = samplerGet(shim->slot);
+    int ticks = sample.value;
+
+    // Each sweep is one sample, however often it is read.
+    mutexTake(shim->mutex, -1);
+    if (shim->count == 0 || sample.sweep != shim->sweep)
+    {
+        shim->newest = (shim->newest + 1) % SHIM_FITMAXWINDOW;
+        shim->samples[shim->newest].ticks = ticks;
+        shim->samples[shim->newest].microTime = sample.microTime;
+        shim->sweep = sample.sweep;
+        if (shim->count < shim->window) shim->count++;
+    }
+
+    // Least squares slope of ticks over time, both relative to the newest
+    // sample so that floats keep their precision.
+    unsigned int count = shim->count;
+    unsigned long now = shim->samples[shim->newest].microTime;
+    float times[SHIM_FITMAXWINDOW];
+    float changes[SHIM_FITMAXWINDOW];
+    for (unsigned int i = 0; i < count; i++)
+    {
+        EncoderFitSample * fitSample =
+            &shim->samples[(shim->newest + SHIM_FITMAXWINDOW - i) % SHIM_FITMAXWINDOW];
+        times[i] = -(float)(now - fitSample->microTime) / 1e6f;
+        changes[i] = fitSample->ticks - ticks;
+    }
     mutexGive(shim->mutex);
 
+    float rpm = slope(times, changes, count) / TICKS_PER_REV_ENCODER * 60.0f;
+    EncoderReading reading =
+    {
+        .revolutions = ((float)(ticks - shim->zero)) / TICKS_PER_REV_ENCODER,
+        .rpm = rpm,
+        .microTime = sample.microTime
+    };
     return reading;
 }
 
+float
+encoderFitPositionGetter(EncoderHandle handle)
+{
+    EncoderFitShim * shim = handle;
+    int ticks = samplerGet(shim->slot).value;
+    return ((float)(ticks - shim->zero)) / TICKS_PER_REV_ENCODER;
+}
+
 void
-encoderResetter(EncoderHandle handle)
+encoderFitResetter(EncoderHandle handle)
 {
-    EncoderShim * shim = handle;
+    EncoderFitShim * shim = handle;
+    shim->zero = samplerGet(shim->slot).value;
     mutexTake(shim->mutex, -1);
-    shim->ticks = 0;
-    encoderReset(shim->encoder);
+    shim->count = 0;
     mutexGive(shim->mutex);
 }
 
 EncoderHandle
-encoderGetHandle(Encoder encoder)
+encoderFitGetHandle(Encoder encoder, unsigned int window)
 {
-    EncoderShim * shim = malloc(sizeof(EncoderShim));
-    shim->encoder = encoder;
-    shim->ticks = encoderGet(encoder);
-    shim->microTime = micros();
+    if (window < 2) window = 2;
+    if (window > SHIM_FITMAXWINDOW) window = SHIM_FITMAXWINDOW;
+
+    EncoderFitShim * shim = malloc(sizeof(EncoderFitShim));
+    shim->slot = samplerAdd(readEncoder, encoder);
+    shim->zero = 0;
+    shim->sweep = 0;
+    shim->newest = 0;
+    shim->count = 0;
+    shim->window = window;
     shim->mutex = mutexCreate();
     return shim;
 }
@@ -77,10 +216,11 @@ encoderGetHandle(Encoder encoder)
 typedef struct
 ImeShim
 {
-    unsigned char address;
+    // Count, then velocity.
+    int slots[2];
+    int zero;
     float gearing;
     float ticksPerRevolution;
-    Mutex mutex;
 }
 ImeShim;
 
@@ -88,53 +228,39 @@ EncoderReading
 imeGetter(EncoderHandle handle)
 {
     ImeShim * shim = handle;
-    mutexTake(shim->mutex, -1);
-    int angle = 0;
-    int rpm = 0;
-    int i;
-    i = 2;
-    while (i > 0)
-    {
-        bool success = imeGetVelocity(shim->address, &rpm);
-        if (success) break;
-        i--;
-    }
-    i = 2;
-    while (i > 0)
-    {
-        bool success = imeGet(shim->address, &angle);
-        if (success) break;
-        i--;
-    }
+    SamplerSample samples[2];
+    samplerGetMany(shim->slots, 2, samples);
     EncoderReading reading =
     {
-        .revolutions = ((float)angle) / shim->ticksPerRevolution,
-        .rpm = ((float)rpm) / shim->gearing
+        .revolutions = ((float)(samples[0].value - shim->zero)) / shim->ticksPerRevolution,
+        .rpm = ((float)samples[1].value) / shim->gearing,
+        .microTime = samples[0].microTime
     };
-    mutexGive(shim->mutex);
     return reading;
 }
 
+float
+imePositionGetter(EncoderHandle handle)
+{
+    ImeShim * shim = handle;
+    int count = samplerGet(shim->slots[0]).value;
+    return ((float)(count - shim->zero)) / shim->ticksPerRevolution;
+}
+
 void
 imeResetter(EncoderHandle handle)
 {
     ImeShim * shim = handle;
-    mutexTake(shim->mutex, -1);
-    int i = 2;
-    while (i > 0)
-    {
-        bool success = imeReset(shim->address);
-        if (success) break;
-        i--;
-    }
-    mutexGive(shim->mutex);
+    shim->zero = samplerGet(shim->slots[0]).value;
 }
 
 EncoderHandle
 imeGetHandle(unsigned char address, MotorType type)
 {
     ImeShim * shim = malloc(sizeof(ImeShim));
-    shim->address = address;
+    shim->slots[0] = samplerAdd(readImeCount, (void *)(uintptr_t)address);
+    shim->slots[1] = samplerAdd(readImeVelocity, (void *)(uintptr_t)address);
+    shim->zero = 0;
     switch (type)
     {
     case MOTOR_TYPE_269:
@@ -150,7 +276,6 @@ imeGetHandle(unsigned char address, MotorType type)
         shim->ticksPerRevolution = TICKS_PER_REV_IME_393_SPEED;
         break;
     }
-    shim->mutex = mutexCreate();
     return shim;
 }
 
@@ -183,12 +308,45 @@ motorGetHandle(unsigned char channel, bool reversed)
     return shim;
 }
 
+typedef struct
+MotorPostShim
+{
+    unsigned char channel;
+    bool reversed;
+    MotorPriority priority;
+}
+MotorPostShim;
+
+void
+motorPostSetter(MotorHandle handle, int command)
+{
+    MotorPostShim * shim = handle;
+    if (shim->reversed) command *= -1;
+    motorsPost(shim->channel, shim->priority, command);
+}
+
+MotorHandle
+motorPostGetHandle(unsigned char channel, bool reversed, MotorPriority priority)
+{
+    MotorPostShim * shim = malloc(sizeof(MotorPostShim));
+    shim->channel = channel;
+    shim->reversed = reversed;
+    shim->priority = priority;
+    return shim;
+}
+
+bool
+motorPostWriteGetter(MotorHandle handle, MotorsWrite * write)
+{
+    MotorPostShim * shim = handle;
+    return motorsGetWrite(shim->channel, shim->priority, write);
+}
+
 typedef struct
 DigitalShim
 {
-    unsigned char port;
+    int slot;
     bool negate;
-    Mutex mutex;
 }
 DigitalShim;
 
@@ -196,10 +354,7 @@ bool
 digitalGetter(DigitalHandle handle)
 {
     DigitalShim * shim = handle;
-
-    mutexTake(shim->mutex, -1);
-    bool value = digitalRead(shim->port);
-    mutexGive(shim->mutex);
+    bool value = samplerGet(shim->slot).value != 0;
 
     // negate if needed
     return shim->negate != value;
@@ -209,9 +364,8 @@ DigitalHandle
 digitalGetHandle(unsigned char port, bool negate)
 {
     DigitalShim * shim = malloc(sizeof(DigitalShim));
-    shim->port = port;
+    shim->slot = samplerAdd(readDigital, (void *)(uintptr_t)port);
     shim->negate = negate;
-    shim->mutex = mutexCreate();
 
     return shim;
 }
@@ -219,11 +373,10 @@ digitalGetHandle(unsigned char port, bool negate)
 typedef struct
 EncoderRangeShim
 {
-    EncoderGetter encoderGet;
+    EncoderPositionGetter positionGet;
     EncoderHandle encoder;
     float lower;
     float upper;
-    Mutex mutex;
 }
 EncoderRangeShim;
 
@@ -231,24 +384,380 @@ bool
 encoderRangeGetter(DigitalHandle handle)
 {
     EncoderRangeShim * shim = handle;
-
-    mutexTake(shim->mutex, -1);
-    float revolutions = shim->encoderGet(shim->encoder).revolutions;
-    mutexGive(shim->mutex);
-
+    float revolutions = shim->positionGet(shim->encoder);
     float degrees = revolutions * SHIM_DEGREES_PER_REV;
     return shim->lower <= degrees && degrees <= shim->upper;
 }
 
 DigitalHandle
-encoderRangeGetHandle(EncoderGetter encoderGetter, EncoderHandle encoder, float upper, float lower)
+encoderRangeGetHandle(
+    EncoderPositionGetter positionGetter,
+    EncoderHandle encoder,
+    float upper,
+    float lower
+)
 {
     EncoderRangeShim * shim = malloc(sizeof(EncoderRangeShim));
-    shim->encoderGet = encoderGetter;
+    shim->positionGet = positionGetter;
     shim->encoder = encoder;
     shim->upper = upper;
     shim->lower = lower;
-    shim->mutex = mutexCreate();
 
     return shim;
 }
+
+typedef struct
+AnalogShim
+{
+    unsigned char channel;
+    unsigned int oversample;
+    AnalogFilter filter;
+    unsigned int window;
+    int slot;
+
+    // Owned by the sampler task: the last window averages, in sixteenths
+    // of a count, and their sum.
+    int averages[SHIM_ANALOGMAXWINDOW];
+    unsigned int newest;
+    unsigned int count;
+    long sum;
+
+    AnalogPoint points[SHIM_ANALOGMAXPOINTS];
+    unsigned int pointCount;
+}
+AnalogShim;
+
+float
+analogGetter(AnalogHandle handle)
+{
+    AnalogShim * shim = handle;
+    float raw = samplerGet(shim->slot).value / 16.0f;
+    unsigned int count = shim->pointCount;
+    if (count < 2) return raw;
+
+    unsigned int i = 1;
+    while (i < count - 1 && raw > shim->points[i].raw) i++;
+    AnalogPoint * low = &shim->points[i - 1];
+    AnalogPoint * high = &shim->points[i];
+    float span = high->raw - low->raw;
+    if (span <= 0.0f) return low->value;
+    return low->value + (raw - low->raw) * (high->value - low->value) / span;
+}
+
+AnalogHandle
+analogGetHandle(unsigned char channel, unsigned int oversample, AnalogFilter filter, unsigned int window)
+{
+    if (oversample < 1) oversample = 1;
+    if (oversample > SHIM_ANALOGMAXOVERSAMPLE) oversample = SHIM_ANALOGMAXOVERSAMPLE;
+    if (window < 1) window = 1;
+    if (window > SHIM_ANALOGMAXWINDOW) window = SHIM_ANALOGMAXWINDOW;
+
+    AnalogShim * shim = malloc(sizeof(AnalogShim));
+    shim->channel = channel;
+    shim->oversample = oversample;
+    shim->filter = filter;
+    shim->window = window;
+    shim->newest = 0;
+    shim->count = 0;
+    shim->sum = 0;
+    shim->pointCount = 0;
+    shim->slot = samplerAdd(readAnalog, shim);
+    return shim;
+}
+
+void
+analogSetCalibration(AnalogHandle handle, const AnalogPoint points[], unsigned int count)
+{
+    AnalogShim * shim = handle;
+    if (count > SHIM_ANALOGMAXPOINTS) count = SHIM_ANALOGMAXPOINTS;
+    for (unsigned int i = 0; i < count; i++) shim->points[i] = points[i];
+    shim->pointCount = count;
+}
+
+typedef struct
+GyroShim
+{
+    Gyro gyro;
+    // Degrees, then rate, in hundredths.
+    int slots[2];
+    float zero;
+
+    // Owned by the sampler task. The rate is fitted to the last window of
+    // raw readings.
+    int raw;
+    unsigned long microTime;
+    int rawWindow[SHIM_GYROWINDOW];
+    unsigned long timeWindow[SHIM_GYROWINDOW];
+    unsigned int newest;
+    unsigned int count;
+    int stillRaw;
+    unsigned long stillTime;
+    float degrees;
+    float rate;
+    float bias;
+}
+GyroShim;
+
+GyroReading
+gyroGetter(GyroHandle handle)
+{
+    GyroShim * shim = handle;
+    SamplerSample samples[2];
+    samplerGetMany(shim->slots, 2, samples);
+    GyroReading reading =
+    {
+        .degrees = samples[0].value / 100.0f - shim->zero,
+        .rate = samples[1].value / 100.0f,
+        .microTime = samples[0].microTime
+    };
+    return reading;
+}
+
+void
+gyroResetter(GyroHandle handle)
+{
+    GyroShim * shim = handle;
+    shim->zero = samplerGet(shim->slots[0]).value / 100.0f;
+}
+
+GyroHandle
+gyroGetHandle(Gyro gyro)
+{
+    GyroShim * shim = malloc(sizeof(GyroShim));
+    shim->gyro = gyro;
+    shim->zero = 0.0f;
+    shim->raw = gyroGet(gyro);
+    shim->microTime = micros();
+    shim->rawWindow[0] = shim->raw;
+    shim->timeWindow[0] = shim->microTime;
+    shim->newest = 0;
+    shim->count = 1;
+    shim->stillRaw = shim->raw;
+    shim->stillTime = shim->microTime;
+    shim->degrees = 0.0f;
+    shim->rate = 0.0f;
+    shim->bias = 0.0f;
+    shim->slots[0] = samplerAdd(readGyroDegrees, shim);
+    shim->slots[1] = samplerAdd(readGyroRate, shim);
+    return shim;
+}
+
+typedef struct
+UltrasonicShim
+{
+    Ultrasonic ultrasonic;
+    int slot;
+
+    // Owned by the sampler task: the last echoes, the next to replace, and
+    // empty reads since.
+    int echoes[SHIM_ULTRASONICWINDOW];
+    unsigned int newest;
+    unsigned int count;
+    unsigned int misses;
+}
+UltrasonicShim;
+
+UltrasonicReading
+ultrasonicGetter(UltrasonicHandle handle)
+{
+    UltrasonicShim * shim = handle;
+    SamplerSample sample = samplerGet(shim->slot);
+    UltrasonicReading reading =
+    {
+        .centimeters = sample.value != ULTRASONIC_NONE? sample.value : 0.0f,
+        .found = sample.value != ULTRASONIC_NONE,
+        .microTime = sample.microTime
+    };
+    return reading;
+}
+
+UltrasonicHandle
+ultrasonicGetHandle(Ultrasonic ultrasonic)
+{
+    UltrasonicShim * shim = malloc(sizeof(UltrasonicShim));
+    shim->ultrasonic = ultrasonic;
+    shim->newest = 0;
+    shim->count = 0;
+    shim->misses = 0;
+    shim->slot = samplerAddEvery(readUltrasonic, shim, SHIM_ULTRASONICINTERVAL);
+    return shim;
+}
+
+// Sampler readers {{{
+
+static int
+readEncoder(void * handle)
+{
+    return encoderGet(handle);
+}
+
+static int
+readImeCount(void * handle)
+{
+    return imesGet((uintptr_t)handle).count;
+}
+
+static int
+readImeVelocity(void * handle)
+{
+    return imesGet((uintptr_t)handle).velocity;
+}
+
+static int
+readDigital(void * handle)
+{
+    return digitalRead((uintptr_t)handle);
+}
+
+static int
+readAnalog(void * handle)
+{
+    AnalogShim * shim = handle;
+    int total = 0;
+    for (unsigned int i = 0; i < shim->oversample; i++) total += analogRead(shim->channel);
+    int average = total * 16 / (int)shim->oversample;
+
+    // The oldest average drops out of the sum once the window is full.
+    shim->newest = (shim->newest + 1) % shim->window;
+    if (shim->count == shim->window) shim->sum -= shim->averages[shim->newest];
+    else shim->count++;
+    shim->averages[shim->newest] = average;
+    shim->sum += average;
+
+    unsigned int count = shim->count;
+    if (shim->filter == ANALOG_FILTER_MEAN) return (shim->sum + count / 2) / count;
+
+    int window[SHIM_ANALOGMAXWINDOW];
+    for (unsigned int i = 0; i < count; i++)
+    {
+        window[i] = shim->averages[(shim->newest + shim->window - i) % shim->window];
+    }
+    return median(window, count);
+}
+
+// Drift is only learnt over whole still windows; any turn past the limit
+// starts the window again.
+static int
+readGyroDegrees(void * handle)
+{
+    GyroShim * shim = handle;
+    unsigned long now = micros();
+    int raw = gyroGet(shim->gyro);
+
+    float dt = (now - shim->microTime) / 1e6f;
+    int change = raw - shim->raw;
+    shim->raw = raw;
+    shim->microTime = now;
+    shim->degrees += change - shim->bias * dt;
+
+    // A whole degree over one sweep is a step of 100 degrees/s, so the
+    // rate is the slope over the window instead.
+    shim->newest = (shim->newest + 1) % SHIM_GYROWINDOW;
+    shim->rawWindow[shim->newest] = raw;
+    shim->timeWindow[shim->newest] = now;
+    if (shim->count < SHIM_GYROWINDOW) shim->count++;
+    float times[SHIM_GYROWINDOW];
+    float changes[SHIM_GYROWINDOW];
+    for (unsigned int i = 0; i < shim->count; i++)
+    {
+        unsigned int at = (shim->newest + SHIM_GYROWINDOW - i) % SHIM_GYROWINDOW;
+        times[i] = -(float)(now - shim->timeWindow[at]) / 1e6f;
+        changes[i] = shim->rawWindow[at] - raw;
+    }
+    shim->rate = slope(times, changes, shim->count) - shim->bias;
+
+    int stillChange = raw - shim->stillRaw;
+    float stillTime = (now - shim->stillTime) / 1e6f;
+    if (stillChange > GYRO_STILLDEGREES || stillChange < -GYRO_STILLDEGREES)
+    {
+        shim->stillRaw = raw;
+        shim->stillTime = now;
+    }
+    else if (stillTime >= GYRO_STILLWINDOW)
+    {
+        shim->bias += (stillChange / stillTime - shim->bias) * GYRO_BIASGAIN;
+        shim->stillRaw = raw;
+        shim->stillTime = now;
+    }
+
+    return shim->degrees * 100.0f + (shim->degrees < 0.0f? -0.5f : 0.5f);
+}
+
+// Called straight after readGyroDegrees in the same sweep.
+static int
+readGyroRate(void * handle)
+{
+    GyroShim * shim = handle;
+    return shim->rate * 100.0f + (shim->rate < 0.0f? -0.5f : 0.5f);
+}
+
+static int
+readUltrasonic(void * handle)
+{
+    UltrasonicShim * shim = handle;
+    int centimeters = ultrasonicGet(shim->ultrasonic);
+    if (centimeters <= 0)
+    {
+        if (shim->misses < SHIM_ULTRASONICWINDOW) shim->misses++;
+    }
+    else
+    {
+        shim->misses = 0;
+        shim->echoes[shim->newest] = centimeters;
+        shim->newest = (shim->newest + 1) % SHIM_ULTRASONICWINDOW;
+        if (shim->count < SHIM_ULTRASONICWINDOW) shim->count++;
+    }
+
+    if (shim->count == 0 || shim->misses >= SHIM_ULTRASONICWINDOW) return ULTRASONIC_NONE;
+    return median(shim->echoes, shim->count);
+}
+
+// }}}
+
+
+
+// Private functions {{{
+
+static int
+median(const int values[], unsigned int count)
+{
+    int sorted[SHIM_ANALOGMAXWINDOW];
+    for (unsigned int i = 0; i < count; i++)
+    {
+        int value = values[i];
+        unsigned int j = i;
+        while (j > 0 && sorted[j - 1] > value)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    if (count % 2 == 1) return sorted[count / 2];
+    return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+// Least squares slope of values over times, or 0 for a single sample, or
+// all at the same time. Both are best relative to the newest sample, so
+// that floats keep their precision.
+static float
+slope(const float times[], const float values[], unsigned int count)
+{
+    float meanTime = 0.0f;
+    float meanValue = 0.0f;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        meanTime += times[i] / count;
+        meanValue += values[i] / count;
+    }
+    float covariance = 0.0f;
+    float variance = 0.0f;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        covariance += (times[i] - meanTime) * (values[i] - meanValue);
+        variance += (times[i] - meanTime) * (times[i] - meanTime);
+    }
+    return variance > 0.0f? covariance / variance : 0.0f;
+}
+
+// }}}
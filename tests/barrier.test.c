@@ -0,0 +1,281 @@
+#include "tap.h"
+#include "barrier.h"
+#include "events.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// forward
+
+void test_waitersOnDifferentSets();
+
+typedef struct
+Waiter
+{
+    BarrierSet set;
+    unsigned long blockTime;
+    BarrierWait wait;
+    pthread_t thread;
+}
+Waiter;
+
+static void startWaiter(Waiter*, BarrierSet, unsigned long blockTime);
+static void * runWaiter(void * waiterPointer);
+
+//
+
+int main()
+{
+    plan(4);
+
+    test_waitersOnDifferentSets();
+
+    done_testing();
+}
+
+// Subtests
+
+void
+test_waitersOnDifferentSets()
+{
+    // 4 tests
+
+    int a = barrierRegister("a");
+    int b = barrierRegister("b");
+
+    // One waiter blocks on a, then a is made ready and straight away this
+    // task waits on b. That wait must not swallow the other's wake.
+    Waiter waiterA;
+    startWaiter(&waiterA, barrierOf(a), 1000);
+    usleep(50000);
+    barrierSet(a, true);
+    BarrierWait waitB = barrierWait(barrierOf(b), 100);
+    pthread_join(waiterA.thread, NULL);
+
+    ok(
+        !waitB.ready,
+        "barrierWait, on a set that never becomes ready, should time out"
+    );
+    ok(
+        waiterA.wait.ready,
+        "barrierWait, on a set made ready, should return ready"
+    );
+    ok(
+        waiterA.wait.waited < 500,
+        "barrierWait, on a set made ready while another set is waited on, should not wait for its timeout"
+    );
+    if (waiterA.wait.waited >= 500) diag("waited %lums", waiterA.wait.waited);
+
+    // Both block, then each set is made ready in turn.
+    barrierSet(a, false);
+    Waiter waiters[2];
+    startWaiter(&waiters[0], barrierOf(a), 1000);
+    startWaiter(&waiters[1], barrierOf(b), 1000);
+    usleep(50000);
+    barrierSet(b, true);
+    barrierSet(a, true);
+    pthread_join(waiters[0].thread, NULL);
+    pthread_join(waiters[1].thread, NULL);
+
+    bool bothSoon =
+        waiters[0].wait.ready && waiters[0].wait.waited < 500 &&
+        waiters[1].wait.ready && waiters[1].wait.waited < 500;
+    ok(
+        bothSoon,
+        "barrierWait, with two waiters on different sets both made ready, should let both through"
+    );
+}
+
+// Helpers
+
+static void
+startWaiter(Waiter * waiter, BarrierSet set, unsigned long blockTime)
+{
+    waiter->set = set;
+    waiter->blockTime = blockTime;
+    pthread_create(&waiter->thread, NULL, runWaiter, waiter);
+}
+
+static void *
+runWaiter(void * waiterPointer)
+{
+    Waiter * waiter = waiterPointer;
+    waiter->wait = barrierWait(waiter->set, waiter->blockTime);
+    return NULL;
+}
+
+// Mock functions
+
+// Mutexes and semaphores are both a binary lock, as on the Cortex; both
+// start available.
+typedef struct
+Lock
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    bool isAvailable;
+}
+Lock;
+
+static void *
+lockCreate()
+{
+    Lock * lock = malloc(sizeof(Lock));
+    pthread_mutex_init(&lock->mutex, NULL);
+    pthread_cond_init(&lock->changed, NULL);
+    lock->isAvailable = true;
+    return lock;
+}
+
+static bool
+lockGive(void * handle)
+{
+    Lock * lock = handle;
+    pthread_mutex_lock(&lock->mutex);
+    bool given = !lock->isAvailable;
+    lock->isAvailable = true;
+    pthread_cond_signal(&lock->changed);
+    pthread_mutex_unlock(&lock->mutex);
+    return given;
+}
+
+static bool
+lockTake(void * handle, unsigned long blockTime)
+{
+    Lock * lock = handle;
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    if (blockTime != (unsigned long)-1)
+    {
+        until.tv_sec += blockTime / 1000;
+        until.tv_nsec += (blockTime % 1000) * 1000000;
+        if (until.tv_nsec >= 1000000000)
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&lock->mutex);
+    while (!lock->isAvailable)
+    {
+        if (blockTime == (unsigned long)-1) pthread_cond_wait(&lock->changed, &lock->mutex);
+        else if (pthread_cond_timedwait(&lock->changed, &lock->mutex, &until) != 0) break;
+    }
+    bool taken = lock->isAvailable;
+    lock->isAvailable = false;
+    pthread_mutex_unlock(&lock->mutex);
+    return taken;
+}
+
+void *
+mutexCreate()
+{
+    return lockCreate();
+}
+
+bool
+mutexGive(void * mutex)
+{
+    return lockGive(mutex);
+}
+
+bool
+mutexTake(void * mutex, const unsigned long blockTime)
+{
+    return lockTake(mutex, blockTime);
+}
+
+void *
+semaphoreCreate()
+{
+    return lockCreate();
+}
+
+bool
+semaphoreGive(void * semaphore)
+{
+    return lockGive(semaphore);
+}
+
+bool
+semaphoreTake(void * semaphore, const unsigned long blockTime)
+{
+    return lockTake(semaphore, blockTime);
+}
+
+unsigned long
+micros()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+unsigned long
+millis()
+{
+    return micros() / 1000;
+}
+
+void
+delay(const unsigned long time)
+{
+    usleep(time * 1000);
+}
+
+void *
+taskCreate(
+    void (*taskCode)(void*),
+    const unsigned int stackDepth,
+    void * parameters,
+    const unsigned int priority)
+{
+    return NULL;
+}
+
+int
+monitorRegister(const char * name)
+{
+    return -1;
+}
+
+void
+monitorBegin(int slot)
+{
+}
+
+void
+monitorEnd(int slot)
+{
+}
+
+Portal *
+pigeonCreatePortal(Pigeon * pigeon, const char * id)
+{
+    return NULL;
+}
+
+void
+portalAddBatch(Portal * portal, PortalEntrySetup * setup)
+{
+}
+
+void
+portalReady(Portal * portal)
+{
+}
+
+void
+portalUpdate(Portal * portal, const char * key)
+{
+}
+
+char *
+stringAppend(char * dest, const char * src, size_t size)
+{
+    return dest;
+}
@@ -0,0 +1,161 @@
+#include "tap.h"
+#include "control.h"
+#include "pigeon.h"
+#include <stddef.h>
+#include <math.h>
+
+// forward
+
+void test_feedforwardSettlesFaster();
+void test_feedforwardCorrectsModelError();
+
+static float estimator(float target);
+static float runStep(ControlHandle, ControlUpdater, float plantScale);
+
+//
+
+int main()
+{
+    plan(4);
+
+    test_feedforwardSettlesFaster();
+    test_feedforwardCorrectsModelError();
+
+    done_testing();
+}
+
+// Subtests
+
+void
+test_feedforwardSettlesFaster()
+{
+    // 2 tests
+
+    ControlHandle tbh = tbhInit(0.2f, 10.0f, estimator);
+    float tbhTime = runStep(tbh, tbhUpdate, 1.0f);
+
+    ControlHandle inner = tbhInit(0.2f, 10.0f, estimator);
+    ControlHandle ff = feedforwardInit(estimator, NULL, tbhUpdate, tbhReset, inner);
+    float ffTime = runStep(ff, feedforwardUpdate, 1.0f);
+
+    diag("time-to-ready, tbh: %.2fs, feedforward + tbh: %.2fs", tbhTime, ffTime);
+    ok(
+        ffTime >= 0.0f,
+        "feedforward + tbh, stepping on an exact plant model, should become ready"
+    );
+    ok(
+        tbhTime < 0.0f || ffTime < tbhTime,
+        "feedforward + tbh, stepping on an exact plant model, should be ready sooner than tbh"
+    );
+}
+
+void
+test_feedforwardCorrectsModelError()
+{
+    // 2 tests
+
+    ControlHandle tbh = tbhInit(0.2f, 10.0f, estimator);
+    float tbhTime = runStep(tbh, tbhUpdate, 0.85f);
+
+    ControlHandle inner = tbhInit(0.2f, 10.0f, estimator);
+    ControlHandle ff = feedforwardInit(estimator, NULL, tbhUpdate, tbhReset, inner);
+    float ffTime = runStep(ff, feedforwardUpdate, 0.85f);
+
+    diag("time-to-ready, tbh: %.2fs, feedforward + tbh: %.2fs", tbhTime, ffTime);
+    ok(
+        ffTime >= 0.0f,
+        "feedforward + tbh, with a 15% weaker plant than modelled, should still become ready"
+    );
+    ok(
+        tbhTime < 0.0f || ffTime < tbhTime,
+        "feedforward + tbh, with a 15% weaker plant than modelled, should be ready sooner than tbh"
+    );
+}
+
+// Helpers
+
+// Same model as the robot's flywheel estimator.
+static float
+estimator(float target)
+{
+    if (target <= 0.0f) return 0.0f;
+    return 18.195f + 2.2052e-5f * target * target;
+}
+
+// First order flywheel whose steady state inverts the estimator (scaled),
+// stepped from rest to 1500rpm. Returns the seconds until the flywheel's
+// ready thresholds hold for a full second, or -1 if it never settles.
+static float
+runStep(ControlHandle control, ControlUpdater update, float plantScale)
+{
+    const float dt = 0.02f;
+    const float timeConstant = 0.8f;
+    const float thresholdError = 10.0f;
+    const float thresholdDerivative = 100.0f;
+
+    ControlSystem system =
+    {
+        .dt = dt,
+        .target = 1500.0f,
+        .goal = 1500.0f
+    };
+
+    float readySince = -1.0f;
+    for (int frame = 0; frame < 60 / dt; frame++)
+    {
+        float time = frame * dt;
+
+        float action = system.action;
+        if (action > 127.0f) action = 127.0f;
+        if (action < -127.0f) action = -127.0f;
+
+        float steady = 0.0f;
+        if (action > 18.195f) steady = sqrtf((action - 18.195f) / 2.2052e-5f);
+        steady *= plantScale;
+
+        float derivative = (steady - system.measured) / timeConstant;
+        system.measured += derivative * dt;
+        system.derivative = derivative;
+        system.error = system.measured - system.target;
+
+        update(control, &system);
+        if (system.action > 127.0f) system.action = 127.0f;
+        if (system.action < -127.0f) system.action = -127.0f;
+
+        bool ready =
+            fabsf(system.error) < thresholdError &&
+            fabsf(system.derivative) < thresholdDerivative;
+        if (!ready) readySince = -1.0f;
+        else if (readySince < 0.0f) readySince = time;
+        else if (time - readySince >= 1.0f) return readySince;
+    }
+    return -1.0f;
+}
+
+// Mock functions
+
+void
+portalUpdate(Portal * portal, const char * key)
+{
+}
+
+void
+portalAddBatch(Portal * portal, PortalEntrySetup * setup)
+{
+}
+
+void
+portalFloatHandler(void * handle, char * message, char * response)
+{
+}
+
+void
+portalBoolHandler(void * handle, char * message, char * response)
+{
+}
+
+bool
+isWithin(float x, float size)
+{
+    return -size < x && x < size;
+}
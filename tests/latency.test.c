@@ -0,0 +1,75 @@
+#include "tap.h"
+#include "latency.h"
+#include <stddef.h>
+
+// forward
+
+void test_latencyPercentile();
+
+//
+
+int main()
+{
+    plan(4);
+
+    test_latencyPercentile();
+
+    done_testing();
+}
+
+// Subtests
+
+void
+test_latencyPercentile()
+{
+    // 4 tests
+
+    LatencyHistogram histogram;
+    latencyInit(&histogram, "test");
+    ok(
+        latencyPercentile(&histogram, 0.5f) == 0,
+        "latencyPercentile, with no samples, should be 0"
+    );
+
+    // 90 under the first limit, 10 between 64us and 128us.
+    for (int i = 0; i < 90; i++) latencyRecord(&histogram, 10);
+    for (int i = 0; i < 10; i++) latencyRecord(&histogram, 100);
+    unsigned long p50 = latencyPercentile(&histogram, 0.5f);
+    ok(
+        p50 == 16,
+        "latencyPercentile, at the median, should be the first bucket's limit"
+    );
+    if (p50 != 16) diag("(got) %lu != %u (expected)", p50, 16);
+
+    unsigned long p95 = latencyPercentile(&histogram, 0.95f);
+    ok(
+        p95 == 128,
+        "latencyPercentile, past the first bucket, should be the limit of the bucket reaching the fraction"
+    );
+    if (p95 != 128) diag("(got) %lu != %u (expected)", p95, 128);
+
+    // The last bucket has no upper limit, so the maximum stands in.
+    latencyReset(&histogram);
+    latencyRecord(&histogram, 20000);
+    latencyRecord(&histogram, 30000);
+    unsigned long p50Last = latencyPercentile(&histogram, 0.5f);
+    ok(
+        p50Last == 30000,
+        "latencyPercentile, landing in the last bucket, should be the maximum"
+    );
+    if (p50Last != 30000) diag("(got) %lu != %u (expected)", p50Last, 30000);
+}
+
+// Mock functions
+
+char *
+stringCopy(char * dest, const char * src, size_t size)
+{
+    return dest;
+}
+
+char *
+stringAppend(char * dest, const char * src, size_t size)
+{
+    return dest;
+}
@@ -1,23 +1,26 @@
 #include "tap.h"
 #include "pigeon.h"
 #include <stddef.h>
+#include <string.h>
 
 // forward
 
 void test_portalFloatHandler();
 void test_portalUintHandler();
 void test_portalUlongHandler();
+void test_portalPeriodHandler();
 void test_portalBoolHandler();
 
 //
 
 int main()
 {
-    plan(20);
+    plan(23);
 
     test_portalFloatHandler();
     test_portalUintHandler();
     test_portalUlongHandler();
+    test_portalPeriodHandler();
     test_portalBoolHandler();
 
     done_testing();
@@ -158,6 +161,36 @@ test_portalUlongHandler()
     );
 }
 
+void
+test_portalPeriodHandler()
+{
+    // 3 tests
+
+    unsigned long x = 123;
+    char res[128];
+    res[0] = '~';
+    portalPeriodHandler(&x, "0", res);
+    ok(
+        x == 123 && res[0] == '~',
+        "portalPeriodHandler, receiving 0, should refuse it and not touch res buffer"
+    );
+    if (x != 123) diag("(got) %lu != %u (expected)", x, 123);
+
+    portalPeriodHandler(&x, "45", res);
+    ok(
+        x == 45,
+        "portalPeriodHandler, receiving valid input, should set ulong's new value"
+    );
+    if (x != 45) diag("(got) %lu != %u (expected)", x, 45);
+
+    portalPeriodHandler(&x, NULL, res);
+    is(
+        res,
+        "45",
+        "portalPeriodHandler, receiving no input, should return value"
+    );
+}
+
 void
 test_portalBoolHandler()
 {
@@ -206,6 +239,12 @@ stringCopy(char * dest, const char * src, size_t size)
     return "";
 }
 
+char *
+stringAppend(char * dest, const char * src, size_t size)
+{
+    return "";
+}
+
 bool
 stringToFloat(const char * string, float * dest)
 {
@@ -213,10 +252,11 @@ stringToFloat(const char * string, float * dest)
     return true;
 }
 
+// Everything but "0" reads as 45.
 bool
 stringToUlong(const char * string, unsigned long * dest)
 {
-    *dest = 45;
+    *dest = strcmp(string, "0") == 0? 0 : 45;
     return true;
 }
 
@@ -0,0 +1,203 @@
+#include "tap.h"
+#include "pipeline.h"
+#include "control.h"
+#include "pigeon.h"
+#include <stddef.h>
+#include <string.h>
+
+// forward
+
+void test_pipelineOrderKeepsFixedLast();
+void test_pipelineSetOrder();
+void test_pipelineSetOrderRefuses();
+
+static Pipeline * makePipeline();
+static bool setOrder(Pipeline*, const char * sequence);
+static float trace(ControlHandle, ControlSystem*);
+
+static char traced[64];
+
+//
+
+int main()
+{
+    plan(9);
+
+    test_pipelineOrderKeepsFixedLast();
+    test_pipelineSetOrder();
+    test_pipelineSetOrderRefuses();
+
+    done_testing();
+}
+
+// Subtests
+
+void
+test_pipelineOrderKeepsFixedLast()
+{
+    // 2 tests
+
+    Pipeline * pipeline = makePipeline();
+    char order[PIGEON_LINESIZE];
+    pipelineGetOrder(pipeline, order);
+    is(
+        order,
+        "a b clamp",
+        "pipeline, with a stage added after a fixed one, should keep the fixed one last"
+    );
+
+    ControlSystem system = {0};
+    traced[0] = '\0';
+    pipelineUpdate(pipeline, &system);
+    is(
+        traced,
+        "a b clamp ",
+        "pipelineUpdate, should run the stages in order"
+    );
+}
+
+void
+test_pipelineSetOrder()
+{
+    // 3 tests
+
+    Pipeline * pipeline = makePipeline();
+    char order[PIGEON_LINESIZE];
+
+    bool set = setOrder(pipeline, "b a");
+    pipelineGetOrder(pipeline, order);
+    ok(set, "pipelineSetOrder, with known stages, should accept them");
+    is(
+        order,
+        "b a clamp",
+        "pipelineSetOrder, leaving out the fixed stage, should still end with it"
+    );
+
+    setOrder(pipeline, "clamp b");
+    pipelineGetOrder(pipeline, order);
+    is(
+        order,
+        "b clamp",
+        "pipelineSetOrder, naming the fixed stage out of place, should keep it last"
+    );
+}
+
+void
+test_pipelineSetOrderRefuses()
+{
+    // 4 tests
+
+    Pipeline * pipeline = makePipeline();
+    char order[PIGEON_LINESIZE];
+
+    bool refused =
+        !setOrder(pipeline, "") &&
+        !setOrder(pipeline, "   ");
+    ok(refused, "pipelineSetOrder, with no stages, should refuse");
+
+    ok(
+        !setOrder(pipeline, "a b a"),
+        "pipelineSetOrder, naming a stage twice, should refuse"
+    );
+    ok(
+        !setOrder(pipeline, "a c") && !setOrder(pipeline, "clamp"),
+        "pipelineSetOrder, with an unknown key or only the fixed stage, should refuse"
+    );
+
+    pipelineGetOrder(pipeline, order);
+    is(
+        order,
+        "a b clamp",
+        "pipelineSetOrder, having refused, should keep the old order"
+    );
+}
+
+// Helpers
+
+static Pipeline *
+makePipeline()
+{
+    PipelineStageSetup stages[] =
+    {
+        {
+            .key = "a",
+            .updater = trace,
+            .handle = "a"
+        },
+        {
+            .key = "clamp",
+            .updater = trace,
+            .handle = "clamp",
+            .fixed = true
+        },
+        {
+            .key = "b",
+            .updater = trace,
+            .handle = "b"
+        },
+
+        // End terminating struct
+        {
+            .key = "~",
+            .updater = NULL
+        }
+    };
+    Pipeline * pipeline = pipelineInit(NULL);
+    pipelineAddBatch(pipeline, stages);
+    return pipeline;
+}
+
+// pipelineSetOrder cuts up its sequence, so it is given a copy.
+static bool
+setOrder(Pipeline * pipeline, const char * sequence)
+{
+    char copy[PIGEON_LINESIZE];
+    strcpy(copy, sequence);
+    return pipelineSetOrder(pipeline, copy);
+}
+
+static float
+trace(ControlHandle handle, ControlSystem * system)
+{
+    strcat(traced, handle);
+    strcat(traced, " ");
+    return system->action;
+}
+
+// Mock functions
+
+void *
+mutexCreate()
+{
+    return (void *)1;
+}
+
+bool
+mutexTake(void * mutex, const unsigned long blockTime)
+{
+    return true;
+}
+
+bool
+mutexGive(void * mutex)
+{
+    return true;
+}
+
+unsigned long
+micros()
+{
+    return 0;
+}
+
+void
+portalAdd(Portal * portal, PortalEntrySetup setup)
+{
+}
+
+char *
+stringAppend(char * dest, const char * src, size_t size)
+{
+    strncat(dest, src, size - strlen(dest) - 1);
+    return dest;
+}
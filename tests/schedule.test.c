@@ -0,0 +1,197 @@
+#include "tap.h"
+#include "schedule.h"
+#include "control.h"
+#include "pigeon.h"
+#include <stddef.h>
+#include <math.h>
+
+// forward
+
+void test_scheduleInterpolates();
+void test_scheduleSortsRows();
+void test_scheduleHoldsEndRows();
+void test_scheduleEmptyAndSingleRow();
+
+typedef struct
+Gains
+{
+    int sets;
+    float gainP;
+    float gainI;
+    float gainD;
+}
+Gains;
+
+static void setGains(ControlHandle, float gainP, float gainI, float gainD);
+static Gains scheduleAt(ControlHandle schedule, float goal);
+static bool isGains(Gains, float gainP, float gainI, float gainD);
+
+static Gains lastGains;
+
+//
+
+int main()
+{
+    plan(7);
+
+    test_scheduleInterpolates();
+    test_scheduleSortsRows();
+    test_scheduleHoldsEndRows();
+    test_scheduleEmptyAndSingleRow();
+
+    done_testing();
+}
+
+// Subtests
+
+void
+test_scheduleInterpolates()
+{
+    // 1 test
+
+    ControlHandle schedule = scheduleInit(setGains, NULL);
+    scheduleSetRow(schedule, 1000.0f, 1.0f, 2.0f, 3.0f);
+    scheduleSetRow(schedule, 2000.0f, 3.0f, 6.0f, 9.0f);
+
+    Gains gains = scheduleAt(schedule, 1250.0f);
+    bool isCorrect = isGains(gains, 1.5f, 3.0f, 4.5f);
+    ok(
+        isCorrect,
+        "schedule, with a goal between two rows, should set the gains interpolated between them"
+    );
+    if (!isCorrect) diag("(got) %f %f %f", gains.gainP, gains.gainI, gains.gainD);
+}
+
+void
+test_scheduleSortsRows()
+{
+    // 2 tests
+
+    ControlHandle schedule = scheduleInit(setGains, NULL);
+    scheduleSetRow(schedule, 3000.0f, 5.0f, 0.0f, 0.0f);
+    scheduleSetRow(schedule, 1000.0f, 1.0f, 0.0f, 0.0f);
+    scheduleSetRow(schedule, 2000.0f, 3.0f, 0.0f, 0.0f);
+
+    ok(
+        isGains(scheduleAt(schedule, 2500.0f), 4.0f, 0.0f, 0.0f),
+        "schedule, with rows set out of order, should interpolate between the neighbouring targets"
+    );
+
+    scheduleSetRow(schedule, 2000.0f, 1.0f, 0.0f, 0.0f);
+    ok(
+        isGains(scheduleAt(schedule, 1500.0f), 1.0f, 0.0f, 0.0f),
+        "schedule, setting a row at an existing target, should replace that row"
+    );
+}
+
+void
+test_scheduleHoldsEndRows()
+{
+    // 2 tests
+
+    ControlHandle schedule = scheduleInit(setGains, NULL);
+    scheduleSetRow(schedule, 1000.0f, 1.0f, 2.0f, 3.0f);
+    scheduleSetRow(schedule, 2000.0f, 3.0f, 6.0f, 9.0f);
+
+    ok(
+        isGains(scheduleAt(schedule, 500.0f), 1.0f, 2.0f, 3.0f),
+        "schedule, with a goal below the table, should hold the first row"
+    );
+    ok(
+        isGains(scheduleAt(schedule, 2500.0f), 3.0f, 6.0f, 9.0f),
+        "schedule, with a goal above the table, should hold the last row"
+    );
+}
+
+void
+test_scheduleEmptyAndSingleRow()
+{
+    // 2 tests
+
+    ControlHandle schedule = scheduleInit(setGains, NULL);
+    ok(
+        scheduleAt(schedule, 1500.0f).sets == 0,
+        "schedule, with no rows, should leave the gains alone"
+    );
+
+    scheduleSetRow(schedule, 1000.0f, 1.0f, 2.0f, 3.0f);
+    bool held =
+        isGains(scheduleAt(schedule, 500.0f), 1.0f, 2.0f, 3.0f) &&
+        isGains(scheduleAt(schedule, 1000.0f), 1.0f, 2.0f, 3.0f) &&
+        isGains(scheduleAt(schedule, 1500.0f), 1.0f, 2.0f, 3.0f);
+    ok(
+        held,
+        "schedule, with a single row, should set its gains for any goal"
+    );
+}
+
+// Helpers
+
+static void
+setGains(ControlHandle handle, float gainP, float gainI, float gainD)
+{
+    lastGains.sets++;
+    lastGains.gainP = gainP;
+    lastGains.gainI = gainI;
+    lastGains.gainD = gainD;
+}
+
+static Gains
+scheduleAt(ControlHandle schedule, float goal)
+{
+    Gains none = {0};
+    lastGains = none;
+    ControlSystem system =
+    {
+        .target = goal,
+        .goal = goal
+    };
+    scheduleUpdate(schedule, &system);
+    return lastGains;
+}
+
+static bool
+isGains(Gains gains, float gainP, float gainI, float gainD)
+{
+    return
+        gains.sets == 1 &&
+        fabsf(gains.gainP - gainP) < 1e-4f &&
+        fabsf(gains.gainI - gainI) < 1e-4f &&
+        fabsf(gains.gainD - gainD) < 1e-4f;
+}
+
+// Mock functions
+
+void *
+mutexCreate()
+{
+    return (void *)1;
+}
+
+bool
+mutexTake(void * mutex, const unsigned long blockTime)
+{
+    return true;
+}
+
+bool
+mutexGive(void * mutex)
+{
+    return true;
+}
+
+void
+portalAdd(Portal * portal, PortalEntrySetup setup)
+{
+}
+
+void
+portalUpdate(Portal * portal, const char * key)
+{
+}
+
+bool
+stringToFloat(const char * string, float * dest)
+{
+    return false;
+}
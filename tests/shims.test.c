@@ -0,0 +1,272 @@
+#include "tap.h"
+#include "sampler.h"
+#include "imes.h"
+#include "motors.h"
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+
+// shims.h brings in the Cortex's API.h, which clashes with the libc
+// headers tap.h needs, so what is tested is declared here to match it.
+
+typedef void * AnalogHandle;
+typedef void * UltrasonicHandle;
+
+typedef enum
+AnalogFilter
+{
+    ANALOG_FILTER_MEAN,
+    ANALOG_FILTER_MEDIAN
+}
+AnalogFilter;
+
+typedef struct
+UltrasonicReading
+{
+    float centimeters;
+    bool found;
+    unsigned long microTime;
+}
+UltrasonicReading;
+
+float analogGetter(AnalogHandle);
+AnalogHandle analogGetHandle(unsigned char channel, unsigned int oversample, AnalogFilter, unsigned int window);
+UltrasonicReading ultrasonicGetter(UltrasonicHandle);
+UltrasonicHandle ultrasonicGetHandle(void * ultrasonic);
+
+// forward
+
+void test_analogMeanFilter();
+void test_analogMedianFilter();
+void test_ultrasonicDropout();
+
+static void sweep(const int values[], int count);
+
+// The sensor's next reading, and the reader and handle the shim left with
+// the sampler.
+static int reading = 0;
+static SamplerReader reader = NULL;
+static void * readerHandle = NULL;
+static int sampled = 0;
+
+//
+
+int main()
+{
+    plan(7);
+
+    test_analogMeanFilter();
+    test_analogMedianFilter();
+    test_ultrasonicDropout();
+
+    done_testing();
+}
+
+// Subtests
+
+void
+test_analogMeanFilter()
+{
+    // 2 tests
+
+    AnalogHandle analog = analogGetHandle(1, 1, ANALOG_FILTER_MEAN, 4);
+
+    int values[] = { 100, 200, 300, 400 };
+    sweep(values, 4);
+    float mean = analogGetter(analog);
+    ok(
+        fabsf(mean - 250.0f) < 0.1f,
+        "analog mean filter, over a full window, should read the mean"
+    );
+    if (fabsf(mean - 250.0f) >= 0.1f) diag("(got) %f != %f (expected)", mean, 250.0f);
+
+    int next[] = { 500 };
+    sweep(next, 1);
+    mean = analogGetter(analog);
+    ok(
+        fabsf(mean - 350.0f) < 0.1f,
+        "analog mean filter, past a full window, should drop the oldest reading"
+    );
+    if (fabsf(mean - 350.0f) >= 0.1f) diag("(got) %f != %f (expected)", mean, 350.0f);
+}
+
+void
+test_analogMedianFilter()
+{
+    // 1 test
+
+    AnalogHandle analog = analogGetHandle(1, 1, ANALOG_FILTER_MEDIAN, 5);
+
+    int values[] = { 100, 102, 1000, 101, 99 };
+    sweep(values, 5);
+    float median = analogGetter(analog);
+    ok(
+        fabsf(median - 101.0f) < 0.1f,
+        "analog median filter, with one spike in the window, should ignore it"
+    );
+    if (fabsf(median - 101.0f) >= 0.1f) diag("(got) %f != %f (expected)", median, 101.0f);
+}
+
+void
+test_ultrasonicDropout()
+{
+    // 4 tests
+
+    UltrasonicHandle ultrasonic = ultrasonicGetHandle(NULL);
+
+    int echoes[] = { 50, 52, 51 };
+    sweep(echoes, 3);
+    UltrasonicReading found = ultrasonicGetter(ultrasonic);
+    ok(
+        found.found && found.centimeters == 51.0f,
+        "ultrasonic, with echoes, should read their median"
+    );
+
+    // 0 is how the API reports no echo.
+    int missed[] = { 0 };
+    sweep(missed, 1);
+    UltrasonicReading held = ultrasonicGetter(ultrasonic);
+    ok(
+        held.found && held.centimeters == 51.0f,
+        "ultrasonic, missing one echo, should hold its reading"
+    );
+
+    int lost[] = { 0, 0, 0, 0, 0 };
+    sweep(lost, 5);
+    UltrasonicReading none = ultrasonicGetter(ultrasonic);
+    ok(
+        !none.found && none.centimeters == 0.0f,
+        "ultrasonic, missing a window of echoes, should read as nothing found"
+    );
+
+    int back[] = { 80 };
+    sweep(back, 1);
+    UltrasonicReading again = ultrasonicGetter(ultrasonic);
+    ok(
+        again.found,
+        "ultrasonic, hearing an echo after losing it, should read as found"
+    );
+}
+
+// Helpers
+
+// Runs the sampler's reader once per value, as successive sweeps would.
+static void
+sweep(const int values[], int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        reading = values[i];
+        sampled = reader(readerHandle);
+    }
+}
+
+// Mock functions
+
+int
+samplerAdd(SamplerReader newReader, void * handle)
+{
+    reader = newReader;
+    readerHandle = handle;
+    return 0;
+}
+
+int
+samplerAddEvery(SamplerReader newReader, void * handle, unsigned long interval)
+{
+    return samplerAdd(newReader, handle);
+}
+
+SamplerSample
+samplerGet(int slot)
+{
+    SamplerSample sample =
+    {
+        .value = sampled
+    };
+    return sample;
+}
+
+void
+samplerGetMany(const int slots[], unsigned int count, SamplerSample samples[])
+{
+}
+
+int
+analogRead(unsigned char channel)
+{
+    return reading;
+}
+
+int
+ultrasonicGet(void * ultrasonic)
+{
+    return reading;
+}
+
+// Unused by these tests, but linked from the shims
+
+int
+encoderGet(void * encoder)
+{
+    return 0;
+}
+
+int
+gyroGet(void * gyro)
+{
+    return 0;
+}
+
+bool
+digitalRead(unsigned char pin)
+{
+    return false;
+}
+
+ImesReading
+imesGet(unsigned char address)
+{
+    ImesReading none = {0};
+    return none;
+}
+
+void
+motorSet(unsigned char channel, int speed)
+{
+}
+
+void
+motorsPost(unsigned char channel, MotorPriority priority, int command)
+{
+}
+
+bool
+motorsGetWrite(unsigned char channel, MotorPriority priority, MotorsWrite * write)
+{
+    return false;
+}
+
+void *
+mutexCreate()
+{
+    return NULL;
+}
+
+bool
+mutexTake(void * mutex, const unsigned long blockTime)
+{
+    return true;
+}
+
+bool
+mutexGive(void * mutex)
+{
+    return true;
+}
+
+unsigned long
+micros()
+{
+    return 0;
+}
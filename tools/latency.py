@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+#
+# Pretty-prints flywheel latency histograms from a pigeon log.
+#
+# Query each stage on the robot with `flywheel.latency-raw <stage>`
+# (wait, sense, control, actuate, flush, loop), capture the output, then:
+#
+#     tools/latency.py < pigeon.log
+#
+# Only the last report of each stage is shown.
+
+import re
+import sys
+
+# Must match LATENCY_NUMOFBUCKETS and the first limit in src/latency.c
+NUMOFBUCKETS = 12
+FIRSTLIMIT = 16
+WIDTH = 50
+
+LINE = re.compile(r'^\[(\d+)\|\s*([\w-]+)\.latency-raw\s*\]\s+(\w+)((?:\s+\d+)+)\s*$')
+
+
+def bucketLabel(bucket):
+    if bucket == NUMOFBUCKETS - 1:
+        return '>=%dus' % (FIRSTLIMIT << (bucket - 1))
+    return '<%dus' % (FIRSTLIMIT << bucket)
+
+
+def main():
+    reports = {}
+    for line in sys.stdin:
+        match = LINE.match(line.strip())
+        if match is None:
+            continue
+        time, portal, stage, counts = match.groups()
+        percents = [int(count) for count in counts.split()]
+        reports[(portal, stage)] = (int(time), percents)
+
+    for (portal, stage), (time, percents) in sorted(reports.items()):
+        print('%s %s (at %dms)' % (portal, stage, time))
+        for bucket, percent in enumerate(percents):
+            bar = '#' * (percent * WIDTH // 100)
+            print('  %9s %3d%% %s' % (bucketLabel(bucket), percent, bar))
+        print()
+
+
+if __name__ == '__main__':
+    main()